@@ -1,13 +1,209 @@
 #include "big_integer.h"
+#include "thread_pool.h"
 
 #include <stdexcept>
 #include <string>
 #include <cstdint>
 #include <utility>
-#include <list>
 #include <algorithm>
 #include <functional>
 #include <vector>
+#include <memory>
+#include <exception>
+#include <istream>
+#include <ostream>
+#include <iterator>
+#include <cmath>
+#include <limits>
+
+// Helpful functions
+
+namespace {
+    using number_t = number_storage::number_t;
+    using big_number_t = number_storage::big_number_t;
+
+    // Decimal conversions work with base 10^9 digits
+    constexpr number_t DECIMAL_CHUNK = 1000000000;
+    constexpr size_t DECIMAL_CHUNK_DIGITS = 9;
+
+    // Writes exactly DECIMAL_CHUNK_DIGITS digits, with leading zeros
+    void write_decimal_chunk(char* out, number_t chunk) {
+        for (size_t i = DECIMAL_CHUNK_DIGITS; i != 0; chunk /= 10) {
+            out[--i] = static_cast<char>('0' + chunk % 10);
+        }
+    }
+
+    char const DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+    // Value of a digit in any base up to 36, 36 for other characters
+    number_t digit_value(char c) {
+        if (c >= '0' && c <= '9') {
+            return static_cast<number_t>(c - '0');
+        }
+        if (c >= 'a' && c <= 'z') {
+            return static_cast<number_t>(c - 'a' + 10);
+        }
+        if (c >= 'A' && c <= 'Z') {
+            return static_cast<number_t>(c - 'A' + 10);
+        }
+        return 36;
+    }
+
+    void check_base(unsigned base) {
+        if (base < 2 || base > 36) {
+            throw std::invalid_argument("Invalid base : " + std::to_string(base));
+        }
+    }
+
+    // Bits per digit for the powers of two, 0 for other bases
+    unsigned digit_bits(unsigned base) {
+        return (base & (base - 1)) == 0 ? static_cast<unsigned>(__builtin_ctz(base)) : 0;
+    }
+
+    // The largest power of the base that fits into number_t, as {power, exponent}
+    std::pair<number_t, size_t> base_chunk(unsigned base) {
+        big_number_t power = base;
+        size_t exponent = 1;
+        while (power * base <= UINT32_MAX) {
+            power *= base;
+            ++exponent;
+        }
+        return {static_cast<number_t>(power), exponent};
+    }
+
+    // Limbs of trunc(|a|), least significant first
+    template <typename F>
+    std::vector<number_t> floating_limbs(F a) {
+        if (!std::isfinite(a)) {
+            throw std::invalid_argument("Infinity or NaN");
+        }
+        // |a| = mantissa * 2^exponent, 0.5 <= mantissa < 1
+        int exponent;
+        F mantissa = std::frexp(std::trunc(std::fabs(a)), &exponent);
+        size_t size = std::max((exponent + 31) / 32, 1);
+        std::vector<number_t> res(size);
+        int bits = exponent - 32 * static_cast<int>(size - 1);
+        for (size_t i = size; i != 0 && mantissa != 0; bits = 32) {
+            mantissa = std::ldexp(mantissa, bits);
+            F limb = std::floor(mantissa);
+            res[--i] = static_cast<number_t>(limb);
+            mantissa -= limb;
+        }
+        return res;
+    }
+
+    // Correctly rounded value of the magnitude val[0 .. n)
+    template <typename F>
+    F to_floating(number_t const* val, size_t n) {
+        constexpr int DIGITS = std::numeric_limits<F>::digits;
+        static_assert(DIGITS < 128, "the mantissa is rounded from 128 bits");
+        number_t top = val[n - 1];
+        if (top == 0) {
+            return 0;
+        }
+        size_t length = 32 * n - static_cast<size_t>(__builtin_clz(top));
+        size_t start = length > 128 ? length - 128 : 0;
+
+        // 32 bits starting at pos
+        auto bits_at = [=](size_t pos) {
+            size_t i = pos / 32;
+            size_t offset = pos % 32;
+            number_t res = i < n ? val[i] >> offset : 0;
+            if (offset != 0 && i + 1 < n) {
+                res |= val[i + 1] << (32 - offset);
+            }
+            return res;
+        };
+        // The highest set bit becomes bit 127, sticky tells if anything below was dropped
+        uint128_t high = 0;
+        for (size_t k = 4; k != 0; ) {
+            high = high << 32 | bits_at(start + 32 * --k);
+        }
+        high <<= 128 - (length - start);
+        bool sticky = (val[start / 32] & ((static_cast<number_t>(1) << (start % 32)) - 1)) != 0;
+        for (size_t i = 0; i != start / 32 && !sticky; ++i) {
+            sticky = val[i] != 0;
+        }
+
+        constexpr int SHIFT = 128 - DIGITS;
+        uint128_t mantissa = high >> SHIFT;
+        uint128_t rest = high & ((static_cast<uint128_t>(1) << SHIFT) - 1);
+        uint128_t half = static_cast<uint128_t>(1) << (SHIFT - 1);
+        if (rest > half || (rest == half && (sticky || (mantissa & 1)))) {
+            ++mantissa;
+        }
+        // Anything past the exponent range becomes infinity anyway
+        int exponent = static_cast<int>(std::min(length, static_cast<size_t>(1) << 20)) - DIGITS;
+        return std::ldexp(static_cast<F>(mantissa), exponent);
+    }
+
+    // Converts (negative ? -1 : 1) * magnitude to an integer type with the range [-max_negative, max_positive]
+    template <typename T>
+    T to_integer(uint128_t magnitude, bool fits, bool negative, uint128_t max_positive, uint128_t max_negative,
+                 bool saturate) {
+        uint128_t limit = negative ? max_negative : max_positive;
+        if (!fits || magnitude > limit) {
+            if (!saturate) {
+                throw std::overflow_error("Value is out of range");
+            }
+            magnitude = limit;
+        }
+        return negative ? static_cast<T>(-magnitude) : static_cast<T>(magnitude);
+    }
+
+    uint128_t const INT128_MAX_VALUE = static_cast<uint128_t>(-1) >> 1;
+
+    std::unique_ptr<thread_pool> mul_pool;
+    size_t mul_parallel_cutoff;
+
+    // x[0 .. n) += y[0 .. m), the carry is propagated up to x[n - 1]
+    // Precondition : n >= m
+    void add_limbs(number_t* x, size_t n, number_t const* y, size_t m) {
+        big_number_t carry = 0;
+        size_t i = 0;
+        for (; i != m; ++i) {
+            carry += static_cast<big_number_t>(x[i]) + y[i];
+            x[i] = static_cast<number_t>(carry);
+            carry >>= 32;
+        }
+        for (; i != n && carry != 0; ++i) {
+            carry += x[i];
+            x[i] = static_cast<number_t>(carry);
+            carry >>= 32;
+        }
+    }
+
+    // x[0 .. n) -= y[0 .. m), x >= y
+    void sub_limbs(number_t* x, size_t n, number_t const* y, size_t m) {
+        number_t borrow = 0;
+        size_t i = 0;
+        for (; i != m; ++i) {
+            number_t cur = x[i];
+            x[i] = cur - y[i] - borrow;
+            borrow = cur < y[i] || (cur == y[i] && borrow);
+        }
+        for (; i != n && borrow != 0; ++i) {
+            borrow = x[i] == 0;
+            --x[i];
+        }
+    }
+
+    // Runs `here` on the calling thread and waits for the group
+    template <typename F>
+    void join(thread_pool& pool, thread_pool::task_group& group, F const& here) {
+        std::exception_ptr error;
+        try {
+            here();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        // Spawned tasks refer to the caller's stack, so wait even if `here` failed
+        pool.wait(group);
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
 
 // Private Methods
 
@@ -50,6 +246,10 @@ int big_integer::cmp_no_sign(big_integer const &rhs) const {
 }
 
 int big_integer::cmp(big_integer const& rhs) const {
+    int64_t x, y;
+    if (to_small(x) && rhs.to_small(y)) {
+        return (x > y) - (x < y);
+    }
     return sign_ ? rhs.sign_ ? -cmp_no_sign(rhs) : -1 : rhs.sign_ ? 1 : cmp_no_sign(rhs);
 }
 
@@ -76,14 +276,26 @@ big_integer::number_t big_integer::mul_long_short(big_integer const& lng, number
 
 big_integer::number_t big_integer::div_long_short(big_integer& lng, number_t shrt) {
     big_number_t carry = 0;
+    iterator val = lng.val_.begin();
     for (size_t i = lng.val_.size(); i != 0; ) {
-        big_number_t tmp = carry * BASE + lng.val_[--i];
-        lng.val_[i] = static_cast<number_t>(tmp / shrt);
+        big_number_t tmp = carry * BASE + val[--i];
+        val[i] = static_cast<number_t>(tmp / shrt);
         carry = tmp % shrt;
     }
     return static_cast<number_t>(carry);
 }
 
+std::vector<big_integer::number_t> big_integer::decimal_chunks() const {
+    std::vector<number_t> res;
+    res.reserve(val_.size() * 10 / 9 + 1);
+    big_integer tmp = *this;
+    do {
+        res.push_back(div_long_short(tmp, DECIMAL_CHUNK));
+        tmp.clear_back();
+    } while (!tmp.is_zero());
+    return res;
+}
+
 big_integer::number_t big_integer::sum_long_long
 (iterator it1, iterator it1_, const_iterator it2, const_iterator it2_,
         void (*const summator)(number_t&, number_t, big_number_t&)) {
@@ -103,18 +315,185 @@ void big_integer::mul_long_long(big_integer& lng1, big_integer const& lng2) {
         return;
     }
     big_integer res(0, lng1.val_.size() + lng2.val_.size());
-    for (size_t i = 0; i < lng1.val_.size(); ++i) {
-        for (size_t j = 0, carry = 0; j < lng2.val_.size() || carry; ++j) {
-            big_number_t cur = res.val_[i + j] + static_cast<big_number_t>(lng1.val_[i]) *
-                                             (j < lng2.val_.size() ? lng2.val_[j] : 0) + carry;
-            res.val_[i + j] = static_cast<number_t>(cur % BASE);
-            carry = cur / BASE;
-        }
+    if (res.val_.is_mapped()) {
+        // Also squares when &lng1 == &lng2
+        mul_chunked(lng1.val_.begin(), lng1.val_.size(), lng2.val_.begin(), lng2.val_.size(), res.val_.begin());
+    } else if (&lng1 == &lng2) {
+        sqr_into(lng1.val_.begin(), lng1.val_.size(), res.val_.begin());
+    } else {
+        mul_into(lng1.val_.begin(), lng1.val_.size(), lng2.val_.begin(), lng2.val_.size(), res.val_.begin());
     }
     res.clear_back();
     res.swap(lng1);
 }
 
+void big_integer::mul_into(const_iterator lng1, size_t n1, const_iterator lng2, size_t n2, iterator res) {
+    mul_karatsuba(lng1, n1, lng2, n2, res, mul_pool.get());
+}
+
+void big_integer::mul_chunked(const_iterator lng1, size_t n1, const_iterator lng2, size_t n2, iterator res) {
+    size_t chunk = std::max(number_storage::mapping_threshold() / 4, static_cast<size_t>(KARATSUBA_CUTOFF));
+    size_t blocks1 = (n1 + chunk - 1) / chunk;
+    size_t blocks2 = (n2 + chunk - 1) / chunk;
+    bool square = lng1 == lng2 && n1 == n2;
+    // Products of blocks i and j with i + j = k fall into res blocks k and k + 1 :
+    // acc holds these two blocks and a carry, block k is final once the diagonal is added
+    std::vector<number_t> prod(2 * chunk);
+    std::vector<number_t> acc(2 * chunk + 2);
+    for (size_t k = 0; k * chunk < n1 + n2; ++k) {
+        size_t i_end = std::min(k + 1, blocks1);
+        for (size_t i = k + 1 > blocks2 ? k + 1 - blocks2 : 0; i < i_end; ++i) {
+            size_t j = k - i;
+            if (square && j < i) {
+                break;
+            }
+            size_t len1 = std::min(chunk, n1 - i * chunk);
+            size_t len2 = std::min(chunk, n2 - j * chunk);
+            if (square && i == j) {
+                sqr_into(lng1 + i * chunk, len1, prod.data());
+            } else {
+                mul_into(lng1 + i * chunk, len1, lng2 + j * chunk, len2, prod.data());
+            }
+            add_limbs(acc.data(), acc.size(), prod.data(), len1 + len2);
+            if (square && i != j) {
+                add_limbs(acc.data(), acc.size(), prod.data(), len1 + len2);
+            }
+        }
+        size_t len = std::min(chunk, n1 + n2 - k * chunk);
+        std::copy(acc.begin(), acc.begin() + len, res + k * chunk);
+        std::copy(acc.begin() + chunk, acc.end(), acc.begin());
+        std::fill(acc.end() - chunk, acc.end(), 0);
+    }
+}
+
+void big_integer::mul_school(const_iterator lng1, size_t n1, const_iterator lng2, size_t n2, iterator res) {
+    std::fill(res, res + n1 + n2, 0);
+    for (size_t i = 0; i != n1; ++i) {
+        big_number_t carry = 0;
+        for (size_t j = 0; j != n2; ++j) {
+            big_number_t cur = res[i + j] + static_cast<big_number_t>(lng1[i]) * lng2[j] + carry;
+            res[i + j] = static_cast<number_t>(cur % BASE);
+            carry = cur / BASE;
+        }
+        res[i + n2] = static_cast<number_t>(carry);
+    }
+}
+
+void big_integer::mul_karatsuba(const_iterator lng1, size_t n1, const_iterator lng2, size_t n2, iterator res,
+                                thread_pool* pool) {
+    if (n1 < n2) {
+        std::swap(lng1, lng2);
+        std::swap(n1, n2);
+    }
+    if (n2 < KARATSUBA_CUTOFF) {
+        mul_school(lng1, n1, lng2, n2, res);
+        return;
+    }
+    if (pool && n2 < mul_parallel_cutoff) {
+        pool = nullptr;
+    }
+
+    if (n1 >= 2 * n2) {
+        // Unbalanced : lng1 is cut into pieces of lng2's length
+        std::fill(res, res + n1 + n2, 0);
+        size_t pieces = (n1 + n2 - 1) / n2;
+        std::vector<std::vector<number_t>> prod(pool ? pieces : 1, std::vector<number_t>(2 * n2));
+        auto piece = [=, &prod](size_t i) {
+            size_t len = std::min(n2, n1 - i * n2);
+            std::vector<number_t>& p = prod[pool ? i : 0];
+            mul_karatsuba(lng1 + i * n2, len, lng2, n2, p.data(), pool);
+            if (!pool) {
+                add_limbs(res + i * n2, n1 + n2 - i * n2, p.data(), len + n2);
+            }
+        };
+        if (pool) {
+            thread_pool::task_group group;
+            for (size_t i = 1; i != pieces; ++i) {
+                pool->spawn(group, [i, &piece] { piece(i); });
+            }
+            join(*pool, group, [&piece] { piece(0); });
+            for (size_t i = 0; i != pieces; ++i) {
+                add_limbs(res + i * n2, n1 + n2 - i * n2, prod[i].data(), std::min(n2, n1 - i * n2) + n2);
+            }
+        } else {
+            for (size_t i = 0; i != pieces; ++i) {
+                piece(i);
+            }
+        }
+        return;
+    }
+
+    // lng = high * BASE^h + low
+    // lng1 * lng2 = z2 * BASE^2h + (z1 - z2 - z0) * BASE^h + z0
+    size_t h = n2 / 2;
+    size_t m1 = n1 - h;
+    size_t m2 = n2 - h;
+    std::vector<number_t> s1(m1 + 1);
+    std::vector<number_t> s2(m2 + 1);
+    std::copy(lng1 + h, lng1 + n1, s1.begin());
+    add_limbs(s1.data(), m1 + 1, lng1, h);
+    std::copy(lng2 + h, lng2 + n2, s2.begin());
+    add_limbs(s2.data(), m2 + 1, lng2, h);
+    std::vector<number_t> z1(m1 + m2 + 2);
+
+    auto low = [=] { mul_karatsuba(lng1, h, lng2, h, res, pool); };
+    auto high = [=] { mul_karatsuba(lng1 + h, m1, lng2 + h, m2, res + 2 * h, pool); };
+    auto middle = [&] { mul_karatsuba(s1.data(), m1 + 1, s2.data(), m2 + 1, z1.data(), pool); };
+    if (pool) {
+        thread_pool::task_group group;
+        pool->spawn(group, low);
+        pool->spawn(group, high);
+        join(*pool, group, middle);
+    } else {
+        low();
+        high();
+        middle();
+    }
+
+    sub_limbs(z1.data(), z1.size(), res, 2 * h);
+    sub_limbs(z1.data(), z1.size(), res + 2 * h, m1 + m2);
+    size_t len = z1.size();
+    while (len != 0 && z1[len - 1] == 0) {
+        --len;
+    }
+    add_limbs(res + h, n1 + n2 - h, z1.data(), len);
+}
+
+void big_integer::sqr_into(const_iterator lng, size_t n, iterator res) {
+    if (n >= KARATSUBA_CUTOFF) {
+        mul_into(lng, n, lng, n, res);
+        return;
+    }
+    std::fill(res, res + 2 * n, 0);
+    // Cross products lng[i] * lng[j], i < j
+    for (size_t i = 0; i + 1 < n; ++i) {
+        big_number_t carry = 0;
+        for (size_t j = i + 1; j != n; ++j) {
+            big_number_t cur = res[i + j] + static_cast<big_number_t>(lng[i]) * lng[j] + carry;
+            res[i + j] = static_cast<number_t>(cur % BASE);
+            carry = cur / BASE;
+        }
+        res[i + n] = static_cast<number_t>(carry);
+    }
+    // Each of them appears twice
+    number_t high_bit = 0;
+    for (size_t i = 0; i != 2 * n; ++i) {
+        number_t cur = res[i];
+        res[i] = (cur << 1) | high_bit;
+        high_bit = cur >> 31;
+    }
+    // Diagonal lng[i] * lng[i]
+    big_number_t carry = 0;
+    for (size_t i = 0; i != n; ++i) {
+        big_number_t sqr = static_cast<big_number_t>(lng[i]) * lng[i];
+        big_number_t low = res[2 * i] + sqr % BASE + carry;
+        res[2 * i] = static_cast<number_t>(low % BASE);
+        big_number_t high = res[2 * i + 1] + sqr / BASE + low / BASE;
+        res[2 * i + 1] = static_cast<number_t>(high % BASE);
+        carry = high / BASE;
+    }
+}
+
 std::pair<big_integer, big_integer> big_integer::div_long_long(big_integer& lng1, big_integer const& lng2) {
     std::pair<big_integer, big_integer> p;
     p.first.val_.resize(lng1.val_.size() - lng2.val_.size() + 1);
@@ -180,6 +559,113 @@ bool big_integer::smaller(big_integer const& lng1, big_integer const& lng2, numb
     return lng1.val_[i + shift] < lng2.val_[i];
 }
 
+void big_integer::assign(uint128_t magnitude, bool negative) {
+    if ((magnitude >> 64) == 0) {
+        val_.assign(static_cast<big_number_t>(magnitude));
+        sign_ = negative && magnitude != 0;
+        return;
+    }
+    val_.resize(1);
+    val_[0] = static_cast<number_t>(magnitude);
+    for (magnitude >>= 32; magnitude != 0; magnitude >>= 32) {
+        val_.push_back(static_cast<number_t>(magnitude));
+    }
+    sign_ = negative && !is_zero();
+}
+
+void big_integer::assign(std::vector<number_t> const& magnitude, bool negative) {
+    val_.resize(magnitude.size());
+    std::copy(magnitude.begin(), magnitude.end(), val_.begin());
+    sign_ = negative;
+    clear_back();
+}
+
+bool big_integer::magnitude_128(uint128_t& magnitude) const {
+    magnitude = 0;
+    for (size_t i = std::min(val_.size(), static_cast<size_t>(4)); i != 0; ) {
+        magnitude = magnitude << 32 | val_[--i];
+    }
+    return val_.size() <= 4;
+}
+
+int big_integer::cmp_builtin(uint64_t magnitude, bool negative) const {
+    if (sign_ != negative) {
+        return sign_ ? -1 : 1;
+    }
+    int res = 1;
+    if (val_.size() <= 2) {
+        uint64_t low = val_.size() == 2 ? static_cast<uint64_t>(val_[1]) << 32 | val_[0] : val_[0];
+        res = (low > magnitude) - (low < magnitude);
+    }
+    return sign_ ? -res : res;
+}
+
+void big_integer::add_builtin(uint64_t magnitude, bool negative) {
+    if (magnitude == 0) {
+        return;
+    }
+    if (is_zero()) {
+        sign_ = negative;
+    }
+    size_t n = std::max(val_.size(), static_cast<size_t>(2));
+    val_.resize(n);
+    iterator val = val_.begin();
+    // Only the two lowest limbs take the operand, the rest just propagate the carry
+    if (sign_ == negative) {
+        big_number_t carry = 0;
+        for (size_t i = 0; i != n && (i < 2 || carry != 0); ++i) {
+            carry += static_cast<big_number_t>(val[i]) + (i < 2 ? static_cast<number_t>(magnitude >> (32 * i)) : 0);
+            val[i] = static_cast<number_t>(carry);
+            carry >>= 32;
+        }
+        if (carry != 0) {
+            val_.push_back(static_cast<number_t>(carry));
+        }
+    } else if (n > 2 || (static_cast<uint64_t>(val[1]) << 32 | val[0]) >= magnitude) {
+        big_number_t borrow = 0;
+        for (size_t i = 0; i != n && (i < 2 || borrow != 0); ++i) {
+            big_number_t sub = (i < 2 ? static_cast<number_t>(magnitude >> (32 * i)) : 0) + borrow;
+            borrow = val[i] < sub;
+            val[i] = static_cast<number_t>(val[i] - sub);
+        }
+    } else {
+        // |*this| < magnitude, the result takes the sign of the operand
+        magnitude -= static_cast<uint64_t>(val[1]) << 32 | val[0];
+        val[0] = static_cast<number_t>(magnitude);
+        val[1] = static_cast<number_t>(magnitude >> 32);
+        sign_ = negative;
+    }
+    clear_back();
+}
+
+void big_integer::mul_builtin(uint64_t magnitude, bool negative) {
+    size_t n = val_.size();
+    val_.resize(n + 2);
+    iterator val = val_.begin();
+    uint128_t carry = 0;
+    for (size_t i = 0; i != n; ++i) {
+        carry += static_cast<uint128_t>(val[i]) * magnitude;
+        val[i] = static_cast<number_t>(carry);
+        carry >>= 32;
+    }
+    val[n] = static_cast<number_t>(carry);
+    val[n + 1] = static_cast<number_t>(carry >> 32);
+    sign_ ^= negative;
+    clear_back();
+}
+
+bool big_integer::to_small(int64_t& value) const {
+    if (val_.size() > 2) {
+        return false;
+    }
+    uint64_t low = val_.size() == 2 ? static_cast<uint64_t>(val_[1]) << 32 | val_[0] : val_[0];
+    if (low > INT64_MAX) {
+        return false;
+    }
+    value = sign_ ? -static_cast<int64_t>(low) : static_cast<int64_t>(low);
+    return true;
+}
+
 void big_integer::into_two_complement() {
     if (sign_) {
         for (auto& el : val_) {
@@ -239,23 +725,96 @@ big_integer::big_integer(int a, size_t size) : big_integer(a) {
     val_.resize(size);
 }
 
-big_integer::big_integer(std::string const& str) : big_integer() {
-    size_t i = (str.front() == '-') ?  1 : 0;
-    for (; i != str.size(); ++i) {
-        if (str[i] < '0' || str[i] > '9') {
+big_integer::big_integer(unsigned a) : big_integer(static_cast<uint128_t>(a))
+{}
+
+big_integer::big_integer(long a) : big_integer(static_cast<int128_t>(a))
+{}
+
+big_integer::big_integer(unsigned long a) : big_integer(static_cast<uint128_t>(a))
+{}
+
+big_integer::big_integer(long long a) : big_integer(static_cast<int128_t>(a))
+{}
+
+big_integer::big_integer(unsigned long long a) : big_integer(static_cast<uint128_t>(a))
+{}
+
+big_integer::big_integer(int128_t a) : big_integer() {
+    // The negation is done in uint128_t, so the minimum value is fine too
+    auto magnitude = static_cast<uint128_t>(a);
+    assign(a < 0 ? -magnitude : magnitude, a < 0);
+}
+
+big_integer::big_integer(uint128_t a) : big_integer() {
+    assign(a, false);
+}
+
+big_integer::big_integer(double a) : big_integer() {
+    assign(floating_limbs(a), a < 0);
+}
+
+big_integer::big_integer(long double a) : big_integer() {
+    assign(floating_limbs(a), a < 0);
+}
+
+void big_integer::set_mul_threads(unsigned threads, size_t cutoff) {
+    mul_pool.reset(threads > 1 ? new thread_pool(threads - 1) : nullptr);
+    mul_parallel_cutoff = std::max(cutoff, static_cast<size_t>(KARATSUBA_CUTOFF));
+}
+
+big_integer::big_integer(std::string const& str) : big_integer(str, 10)
+{}
+
+big_integer::big_integer(std::string const& str, unsigned base) : big_integer() {
+    check_base(base);
+    size_t first = !str.empty() && str.front() == '-' ? 1 : 0;
+    if (str.size() == first) {
+        throw std::runtime_error("Empty string");
+    }
+    for (size_t i = first; i != str.size(); ++i) {
+        if (digit_value(str[i]) >= base) {
             std::string message = "Invalid character : ";
             message += str[i];
             throw std::runtime_error(message);
         }
-        number_t remainder = mul_long_short(*this, 10, *this);
-        if (remainder > 0) {
-            val_.push_back(remainder);
-        }
-        add_long_short(*this, str[i] - 48);
     }
-    if (str.front() == '-' && !is_zero()) {
-        sign_ = true;
+
+    size_t digits = str.size() - first;
+    unsigned bits = digit_bits(base);
+    if (bits != 0) {
+        // Digit k from the end occupies bits [k * bits, (k + 1) * bits)
+        val_.resize(std::max((digits * bits + 31) / 32, static_cast<size_t>(1)));
+        iterator val = val_.begin();
+        size_t pos = 0;
+        for (size_t i = str.size(); i != first; pos += bits) {
+            number_t digit = digit_value(str[--i]);
+            val[pos / 32] |= digit << (pos % 32);
+            if (pos % 32 + bits > 32) {
+                val[pos / 32 + 1] |= digit >> (32 - pos % 32);
+            }
+        }
+    } else {
+        // Digits are applied a whole number_t at a time, the first group takes the remainder
+        size_t chunk = base_chunk(base).second;
+        size_t i = first;
+        size_t end = first + (digits % chunk == 0 ? chunk : digits % chunk);
+        for (; i != str.size(); end += chunk) {
+            number_t value = 0;
+            number_t scale = 1;
+            for (; i != end; ++i) {
+                value = value * base + digit_value(str[i]);
+                scale *= base;
+            }
+            number_t remainder = mul_long_short(*this, scale, *this);
+            if (remainder > 0) {
+                val_.push_back(remainder);
+            }
+            add_long_short(*this, value);
+        }
     }
+    clear_back();
+    sign_ = first == 1 && !is_zero();
 }
 
 void big_integer::swap(big_integer& num) {
@@ -263,6 +822,19 @@ void big_integer::swap(big_integer& num) {
     val_.swap(num.val_);
 }
 
+big_integer::big_integer(big_integer&& other) noexcept : val_(std::move(other.val_)), sign_(other.sign_) {
+    other.sign_ = false;
+}
+
+big_integer& big_integer::operator=(big_integer&& other) noexcept {
+    if (this != &other) {
+        val_ = std::move(other.val_);
+        sign_ = other.sign_;
+        other.sign_ = false;
+    }
+    return *this;
+}
+
 big_integer& big_integer::operator=(big_integer const& other) {
     if (this != & other) {
         val_ = other.val_;
@@ -272,6 +844,11 @@ big_integer& big_integer::operator=(big_integer const& other) {
 }
 
 big_integer& big_integer::operator+=(big_integer const& rhs) {
+    int64_t x, y, res;
+    if (to_small(x) && rhs.to_small(y) && !__builtin_add_overflow(x, y, &res)) {
+        assign(magnitude(res), res < 0);
+        return *this;
+    }
     number_t remainder;
     if (cmp_no_sign(rhs) >= 0) {
         remainder = sum_long_long(val_.begin(),val_.end(), rhs.val_.begin(), rhs.val_.end(),
@@ -291,6 +868,11 @@ big_integer& big_integer::operator+=(big_integer const& rhs) {
 }
 
 big_integer& big_integer::operator-=(big_integer const& rhs) {
+    int64_t x, y, res;
+    if (to_small(x) && rhs.to_small(y) && !__builtin_sub_overflow(x, y, &res)) {
+        assign(magnitude(res), res < 0);
+        return *this;
+    }
     number_t remainder;
     if (cmp_no_sign(rhs) >= 0) {
         remainder = sum_long_long(val_.begin(),val_.end(), rhs.val_.begin(), rhs.val_.end(),
@@ -310,6 +892,11 @@ big_integer& big_integer::operator-=(big_integer const& rhs) {
 }
 
 big_integer& big_integer::operator*=(big_integer const& rhs) {
+    int64_t x, y, res;
+    if (to_small(x) && rhs.to_small(y) && !__builtin_mul_overflow(x, y, &res)) {
+        assign(magnitude(res), res < 0);
+        return *this;
+    }
     bool sign = sign_ != rhs.sign_;
     mul_long_long(*this, rhs);
     sign_ = is_zero() ? false : sign;
@@ -317,6 +904,13 @@ big_integer& big_integer::operator*=(big_integer const& rhs) {
 }
 
 big_integer& big_integer::operator/=(big_integer const& rhs) {
+    // INT64_MIN never comes out of to_small, so x / y can't overflow
+    int64_t x, y;
+    if (to_small(x) && rhs.to_small(y) && y != 0) {
+        x /= y;
+        assign(magnitude(x), x < 0);
+        return *this;
+    }
     bool sign = (!sign_ && rhs.sign_) || (sign_ && !rhs.sign_);
     if (rhs.val_.size() == 1) {
         div_long_short(*this, rhs.val_.back());
@@ -336,8 +930,15 @@ big_integer& big_integer::operator/=(big_integer const& rhs) {
 }
 
 big_integer& big_integer::operator%=(big_integer const& rhs) {
+    int64_t x, y;
+    if (to_small(x) && rhs.to_small(y) && y != 0) {
+        x %= y;
+        assign(magnitude(x), x < 0);
+        return *this;
+    }
     if (rhs.val_.size() == 1) {
-        big_integer tmp = div_long_short(*this, rhs.val_.back());
+        big_integer tmp;
+        tmp.val_[0] = div_long_short(*this, rhs.val_.back());
         val_.swap(tmp.val_);
         sign_ = is_zero() ? false : sign_;
         return *this;
@@ -385,7 +986,7 @@ big_integer& big_integer::operator<<=(int rhs) {
         size_t pos2 = val_.size() - 1;
         while (pos1 != 0) {
             number_t MASK1 = val_[pos1] << shift;
-            number_t MASK2 = val_[pos1 - 1] >> (32 - shift);
+            number_t MASK2 = shift == 0 ? 0 : val_[pos1 - 1] >> (32 - shift);
             val_[pos2] = (MASK1 | MASK2);
             --pos1;
             --pos2;
@@ -404,18 +1005,32 @@ big_integer& big_integer::operator>>=(int rhs) {
         size_t pos1 = 0;
         number_t shift = rhs % 32;
         size_t pos2 = static_cast<number_t>(rhs) / 32;
-        while (pos2 != val_.size() - 1) {
-            number_t MASK2 = val_[pos2 + 1] << (32 - shift);
-            number_t MASK1 = val_[pos2] >> shift;
-            val_[pos1] = (MASK1 | MASK2);
-            ++pos1;
-            ++pos2;
+        // Negative numbers are rounded towards minus infinity
+        bool round_up = false;
+        if (sign_) {
+            for (size_t i = 0; i != std::min(pos2, val_.size()) && !round_up; ++i) {
+                round_up = val_[i] != 0;
+            }
+            if (!round_up && pos2 < val_.size()) {
+                round_up = (val_[pos2] & ((static_cast<number_t>(1) << shift) - 1)) != 0;
+            }
         }
-        val_[pos1] = val_[pos2] >> shift;
-        while (pos1 != val_.size() - 1) {
-            val_[++pos1] = 0;
+        if (pos2 >= val_.size()) {
+            std::fill(val_.begin(), val_.end(), 0);
+        } else {
+            while (pos2 != val_.size() - 1) {
+                number_t MASK2 = shift == 0 ? 0 : val_[pos2 + 1] << (32 - shift);
+                number_t MASK1 = val_[pos2] >> shift;
+                val_[pos1] = (MASK1 | MASK2);
+                ++pos1;
+                ++pos2;
+            }
+            val_[pos1] = val_[pos2] >> shift;
+            while (pos1 != val_.size() - 1) {
+                val_[++pos1] = 0;
+            }
         }
-        if (sign_) {
+        if (round_up) {
             add_long_short(*this, 1);
         }
         clear_back();
@@ -507,11 +1122,14 @@ big_integer operator>>(big_integer a, int b) {
 }
 
 bool operator==(big_integer const& a, big_integer const& b) {
+    if (a.sign_ == b.sign_ && a.val_.shares_data(b.val_)) {
+        return true;
+    }
     return a.cmp(b) == 0;
 }
 
 bool operator!=(big_integer const& a, big_integer const& b) {
-    return a.cmp(b) != 0;
+    return !(a == b);
 }
 
 bool operator<(big_integer const& a, big_integer const& b) {
@@ -534,22 +1152,270 @@ bool operator>=(big_integer const& a, big_integer const& b)
 }
 
 std::string to_string(big_integer const& a) {
-    if (a.is_zero()) {
-        return "0";
+    std::vector<big_integer::number_t> chunks = a.decimal_chunks();
+    std::string res = a.sign_ ? "-" : "";
+    res += std::to_string(chunks.back());
+    size_t size = res.size();
+    res.resize(size + DECIMAL_CHUNK_DIGITS * (chunks.size() - 1));
+    for (size_t i = chunks.size() - 1; i != 0; size += DECIMAL_CHUNK_DIGITS) {
+        write_decimal_chunk(&res[size], chunks[--i]);
     }
-    std::list<char> l;
-    big_integer tmp = a;
-    while (!tmp.is_zero()) {
-        big_integer::number_t reminder = big_integer::div_long_short(tmp, 10);
-        tmp.clear_back();
-        l.push_front(static_cast<char>(reminder + 48));
+    return res;
+}
+
+big_integer pow(big_integer const& a, uint64_t n) {
+    using number_t = big_integer::number_t;
+    if (n == 0) {
+        return 1;
+    }
+    if (n == 1 || a.is_zero()) {
+        return a;
+    }
+    bool sign = a.sign_ && (n & 1);
+    size_t size = a.val_.size();
+    number_t high = a.val_.back();
+    uint64_t bits = 32 * (size - 1) + (32 - __builtin_clz(high));
+
+    // |a| = 2^k : a^n = 2^(k * n)
+    bool power_of_two = (high & (high - 1)) == 0 &&
+                        std::all_of(a.val_.begin(), a.val_.end() - 1, [](number_t x) { return x == 0; });
+    if (power_of_two) {
+        uint64_t shift = (bits - 1) * n;
+        big_integer res(0, shift / 32 + 1);
+        res.val_.back() = static_cast<number_t>(1) << (shift % 32);
+        res.sign_ = sign;
+        return res;
+    }
+
+    // |a^m| < 2^(bits * m), so neither a square nor a product of the
+    // intermediate values needs more than bits * n / 32 + 2 limbs.
+    size_t capacity = bits * n / 32 + 2;
+    big_integer res;
+    big_integer scratch;
+    res.val_.reserve(capacity);
+    scratch.val_.reserve(capacity);
+    res.val_.resize(size);
+    std::copy(a.val_.begin(), a.val_.end(), res.val_.begin());
+
+    for (int i = 62 - __builtin_clzll(n); i >= 0; --i) {
+        scratch.val_.resize(2 * res.val_.size());
+        big_integer::sqr_into(res.val_.begin(), res.val_.size(), scratch.val_.begin());
+        scratch.clear_back();
+        res.swap(scratch);
+        if ((n >> i) & 1) {
+            scratch.val_.resize(res.val_.size() + size);
+            big_integer::mul_into(res.val_.begin(), res.val_.size(), a.val_.begin(), size, scratch.val_.begin());
+            scratch.clear_back();
+            res.swap(scratch);
+        }
+    }
+    res.sign_ = sign;
+    return res;
+}
+
+std::string to_string(big_integer const& a, unsigned base) {
+    check_base(base);
+    if (base == 10) {
+        return to_string(a);
+    }
+    std::string res;
+    unsigned bits = digit_bits(base);
+    if (bits != 0) {
+        size_t n = a.val_.size();
+        number_t top = a.val_.back();
+        size_t length = 32 * (n - 1) + (top == 0 ? 0 : 32 - static_cast<size_t>(__builtin_clz(top)));
+        size_t digits = std::max((length + bits - 1) / bits, static_cast<size_t>(1));
+        res.resize(a.sign_ + digits);
+        big_integer::const_iterator val = a.val_.begin();
+        number_t mask = base - 1;
+        char* out = &res.back();
+        for (size_t pos = 0; pos < digits * bits; pos += bits) {
+            number_t digit = val[pos / 32] >> (pos % 32);
+            if (pos % 32 + bits > 32 && pos / 32 + 1 != n) {
+                digit |= val[pos / 32 + 1] << (32 - pos % 32);
+            }
+            *out-- = DIGITS[digit & mask];
+        }
+    } else {
+        std::pair<number_t, size_t> chunk = base_chunk(base);
+        std::vector<number_t> chunks;
+        big_integer tmp = a;
+        do {
+            chunks.push_back(big_integer::div_long_short(tmp, chunk.first));
+            tmp.clear_back();
+        } while (!tmp.is_zero());
+
+        size_t head = 0;
+        for (number_t top = chunks.back(); top != 0 || head == 0; top /= base) {
+            ++head;
+        }
+        res.resize(a.sign_ + head + chunk.second * (chunks.size() - 1));
+        char* out = &res.back();
+        for (size_t i = 0; i != chunks.size(); ++i) {
+            number_t value = chunks[i];
+            for (size_t k = i + 1 == chunks.size() ? head : chunk.second; k != 0; --k, value /= base) {
+                *out-- = DIGITS[value % base];
+            }
+        }
     }
     if (a.sign_) {
-        l.push_front('-');
+        res[0] = '-';
     }
-    return std::string(l.begin(), l.end());
+    return res;
+}
+
+int64_t to_int64(big_integer const& a) {
+    uint128_t magnitude;
+    bool fits = a.magnitude_128(magnitude);
+    return to_integer<int64_t>(magnitude, fits, a.sign_, INT64_MAX, static_cast<uint128_t>(INT64_MAX) + 1, false);
+}
+
+uint64_t to_uint64(big_integer const& a) {
+    uint128_t magnitude;
+    bool fits = a.magnitude_128(magnitude);
+    return to_integer<uint64_t>(magnitude, fits, a.sign_, UINT64_MAX, 0, false);
+}
+
+int128_t to_int128(big_integer const& a) {
+    uint128_t magnitude;
+    bool fits = a.magnitude_128(magnitude);
+    return to_integer<int128_t>(magnitude, fits, a.sign_, INT128_MAX_VALUE, INT128_MAX_VALUE + 1, false);
+}
+
+uint128_t to_uint128(big_integer const& a) {
+    uint128_t magnitude;
+    bool fits = a.magnitude_128(magnitude);
+    return to_integer<uint128_t>(magnitude, fits, a.sign_, static_cast<uint128_t>(-1), 0, false);
+}
+
+int64_t saturate_int64(big_integer const& a) {
+    uint128_t magnitude;
+    bool fits = a.magnitude_128(magnitude);
+    return to_integer<int64_t>(magnitude, fits, a.sign_, INT64_MAX, static_cast<uint128_t>(INT64_MAX) + 1, true);
+}
+
+uint64_t saturate_uint64(big_integer const& a) {
+    uint128_t magnitude;
+    bool fits = a.magnitude_128(magnitude);
+    return to_integer<uint64_t>(magnitude, fits, a.sign_, UINT64_MAX, 0, true);
+}
+
+int128_t saturate_int128(big_integer const& a) {
+    uint128_t magnitude;
+    bool fits = a.magnitude_128(magnitude);
+    return to_integer<int128_t>(magnitude, fits, a.sign_, INT128_MAX_VALUE, INT128_MAX_VALUE + 1, true);
+}
+
+uint128_t saturate_uint128(big_integer const& a) {
+    uint128_t magnitude;
+    bool fits = a.magnitude_128(magnitude);
+    return to_integer<uint128_t>(magnitude, fits, a.sign_, static_cast<uint128_t>(-1), 0, true);
+}
+
+double to_double(big_integer const& a) {
+    double res = to_floating<double>(a.val_.begin(), a.val_.size());
+    return a.sign_ ? -res : res;
+}
+
+long double to_long_double(big_integer const& a) {
+    long double res = to_floating<long double>(a.val_.begin(), a.val_.size());
+    return a.sign_ ? -res : res;
+}
+
+big_integer gcd(big_integer a, big_integer b) {
+    a.sign_ = false;
+    b.sign_ = false;
+    // Once the operands fit into a machine word the remainders take the fast path
+    while (!b.is_zero()) {
+        a %= b;
+        a.swap(b);
+    }
+    return a;
 }
 
 std::ostream& operator<<(std::ostream& s, big_integer const& a) {
-    return s << to_string(a);
-}
\ No newline at end of file
+    std::ostream::sentry guard(s);
+    if (!guard) {
+        return s;
+    }
+    std::vector<big_integer::number_t> chunks = a.decimal_chunks();
+    std::string head = a.sign_ ? "-" : "";
+    head += std::to_string(chunks.back());
+
+    size_t size = head.size() + DECIMAL_CHUNK_DIGITS * (chunks.size() - 1);
+    size_t width = s.width() > 0 ? static_cast<size_t>(s.width()) : 0;
+    size_t padding = width > size ? width - size : 0;
+    bool left = (s.flags() & std::ios_base::adjustfield) == std::ios_base::left;
+    s.width(0);
+    if (!left) {
+        std::fill_n(std::ostreambuf_iterator<char>(s), padding, s.fill());
+    }
+
+    s.write(head.data(), static_cast<std::streamsize>(head.size()));
+    char block[DECIMAL_CHUNK_DIGITS * 512];
+    size_t used = 0;
+    for (size_t i = chunks.size() - 1; i != 0 && s; ) {
+        write_decimal_chunk(block + used, chunks[--i]);
+        used += DECIMAL_CHUNK_DIGITS;
+        if (used == sizeof(block) || i == 0) {
+            s.write(block, static_cast<std::streamsize>(used));
+            used = 0;
+        }
+    }
+
+    if (left) {
+        std::fill_n(std::ostreambuf_iterator<char>(s), padding, s.fill());
+    }
+    return s;
+}
+
+std::istream& operator>>(std::istream& s, big_integer& a) {
+    std::istream::sentry guard(s);
+    if (!guard) {
+        return s;
+    }
+    big_integer res;
+    int c = s.peek();
+    bool negative = c == '-';
+    if (c == '-' || c == '+') {
+        s.get();
+        c = s.peek();
+    }
+
+    // Digits are gathered into a number_t and applied to res DECIMAL_CHUNK_DIGITS at a time
+    bool empty = true;
+    big_integer::number_t chunk = 0;
+    big_integer::number_t scale = 1;
+    auto flush = [&] {
+        big_integer::number_t remainder = big_integer::mul_long_short(res, scale, res);
+        if (remainder > 0) {
+            res.val_.push_back(remainder);
+        }
+        big_integer::add_long_short(res, chunk);
+        chunk = 0;
+        scale = 1;
+    };
+    while (c >= '0' && c <= '9') {
+        s.get();
+        empty = false;
+        chunk = chunk * 10 + static_cast<big_integer::number_t>(c - '0');
+        scale *= 10;
+        if (scale == DECIMAL_CHUNK) {
+            flush();
+        }
+        c = s.peek();
+    }
+    if (empty) {
+        s.setstate(std::ios_base::failbit);
+        return s;
+    }
+    flush();
+    res.sign_ = negative && !res.is_zero();
+    a.swap(res);
+    return s;
+}
+
+size_t std::hash<big_integer>::operator()(big_integer const& a) const {
+    // Numbers are normalized, so equal values have equal limbs
+    return a.val_.hash() ^ (a.sign_ ? ~static_cast<size_t>(0) : 0);
+}
@@ -5,8 +5,15 @@
 #include <cstdint>
 #include <vector>
 #include <functional>
+#include <type_traits>
 #include "number_storage.h"
 
+class thread_pool;
+enum class byte_order;
+
+__extension__ typedef __int128 int128_t;
+__extension__ typedef unsigned __int128 uint128_t;
+
 class big_integer {
     using iterator = number_storage::iterator;
     using const_iterator = number_storage::const_iterator;
@@ -16,6 +23,11 @@ class big_integer {
     constexpr static number_t NUMBER_MAX = UINT32_MAX;
     constexpr static big_number_t BASE = static_cast<big_number_t>(NUMBER_MAX) + 1;
 
+    // Shorter operands are multiplied by the schoolbook method
+    constexpr static size_t KARATSUBA_CUTOFF = 48;
+    // Default limb count of the shorter operand starting from which subproducts run in parallel
+    constexpr static size_t PARALLEL_MUL_CUTOFF = 1024;
+
     number_storage val_;
     bool sign_;
 
@@ -47,6 +59,9 @@ class big_integer {
     // lng' = lng / shrt
     static number_t div_long_short(big_integer& lng, number_t shrt);
 
+    // Base 10^9 digits of the magnitude, least significant first
+    std::vector<number_t> decimal_chunks() const;
+
     // Apply the summator to the two transmitted sequences.
     // Precondition : it1_ - it1 >= it_2 - it2
     static number_t sum_long_long(iterator it1, iterator it1_, const_iterator it2, const_iterator it2_,
@@ -55,6 +70,27 @@ class big_integer {
     // lng1' = lng1 * lng2
     static void mul_long_long(big_integer& lng1, big_integer const& lng2);
 
+    // res[0 .. n1 + n2) = lng1 * lng2
+    // Precondition : res doesn't overlap with lng1 and lng2
+    static void mul_into(const_iterator lng1, size_t n1, const_iterator lng2, size_t n2, iterator res);
+
+    static void mul_school(const_iterator lng1, size_t n1, const_iterator lng2, size_t n2, iterator res);
+
+    // Subproducts are handed to the pool while the operands are long enough, pool may be nullptr
+    static void mul_karatsuba(const_iterator lng1, size_t n1, const_iterator lng2, size_t n2, iterator res,
+                              thread_pool* pool);
+
+    // res[0 .. n1 + n2) = lng1 * lng2 for a res in mapped storage. The operands are cut into
+    // blocks of max(mapping_threshold() / 4, KARATSUBA_CUTOFF) limbs and the block products
+    // are summed diagonal by diagonal in scratch memory, so every block of res is written once,
+    // in order. Block products go through mul_into and sqr_into (squares when lng1 == lng2).
+    // Precondition : res doesn't overlap with lng1 and lng2
+    static void mul_chunked(const_iterator lng1, size_t n1, const_iterator lng2, size_t n2, iterator res);
+
+    // res[0 .. 2 * n) = lng * lng, every cross product is computed once
+    // Precondition : res doesn't overlap with lng
+    static void sqr_into(const_iterator lng, size_t n, iterator res);
+
     // Methods for long division
 
     // lng1' = lng1 / lng2
@@ -69,19 +105,70 @@ class big_integer {
 
     void into_two_complement();
 
+    // Methods for builtin integer operands, the value is (negative ? -1 : 1) * magnitude :
+
+    template <typename T, typename R>
+    using if_builtin = typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+                                               sizeof(T) <= sizeof(uint64_t), R>::type;
+
+    template <typename T>
+    static uint64_t magnitude(T value) {
+        return value < 0 ? -static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    }
+
+    int cmp_builtin(uint64_t magnitude, bool negative) const;
+    // (*this)' = *this + value
+    void add_builtin(uint64_t magnitude, bool negative);
+    // (*this)' = *this * value
+    void mul_builtin(uint64_t magnitude, bool negative);
+
+    // Methods for conversions :
+
+    // *this' = (negative ? -1 : 1) * magnitude
+    void assign(uint128_t magnitude, bool negative);
+    void assign(std::vector<number_t> const& magnitude, bool negative);
+    // magnitude = |*this| mod 2^128, returns whether |*this| < 2^128
+    bool magnitude_128(uint128_t& magnitude) const;
+
+    // Values that fit into the inline storage and into int64_t take the fast path of the
+    // arithmetic operators : overflow-checked builtins, no limb loops. Returns whether it fits.
+    bool to_small(int64_t& value) const;
+
     // (*this)' = bit_op(*this, rhs)
     void apply_bit_op(big_integer const & rhs, std::function<number_t(number_t, number_t)> const& bit_op);
 
 public:
     big_integer();
     big_integer(big_integer const& other) = default;
+    // The moved-from value becomes 0
+    big_integer(big_integer&& other) noexcept;
     big_integer(int a);
     big_integer(int a, size_t size);
+    big_integer(unsigned a);
+    big_integer(long a);
+    big_integer(unsigned long a);
+    big_integer(long long a);
+    big_integer(unsigned long long a);
+    big_integer(int128_t a);
+    big_integer(uint128_t a);
+    // Rounds toward zero, throws std::invalid_argument for infinities and NaN
+    explicit big_integer(double a);
+    explicit big_integer(long double a);
     explicit big_integer(std::string const& str);
+    // Digits 0-9 and letters of either case, an optional leading '-'.
+    // Bases 2, 4, 8, 16 and 32 are read straight into the limb bits.
+    // Throws std::invalid_argument unless 2 <= base <= 36.
+    big_integer(std::string const& str, unsigned base);
+
+    // Multiplications whose shorter operand has at least `cutoff` limbs split their
+    // subproducts across `threads` threads. threads <= 1 turns it off.
+    // Must not be called while other threads multiply big_integers.
+    static void set_mul_threads(unsigned threads, size_t cutoff = PARALLEL_MUL_CUTOFF);
 
     void swap(big_integer& num);
 
     big_integer& operator=(big_integer const& other);
+    big_integer& operator=(big_integer&& other) noexcept;
 
     big_integer& operator+=(big_integer const& rhs);
     big_integer& operator-=(big_integer const& rhs);
@@ -93,6 +180,25 @@ public:
     big_integer& operator|=(big_integer const& rhs);
     big_integer& operator^=(big_integer const& rhs);
 
+    // Integer operands up to 64 bits are applied to the limbs directly, without a temporary big_integer
+    template <typename T>
+    if_builtin<T, big_integer&> operator+=(T rhs) {
+        add_builtin(magnitude(rhs), rhs < 0);
+        return *this;
+    }
+
+    template <typename T>
+    if_builtin<T, big_integer&> operator-=(T rhs) {
+        add_builtin(magnitude(rhs), !(rhs < 0));
+        return *this;
+    }
+
+    template <typename T>
+    if_builtin<T, big_integer&> operator*=(T rhs) {
+        mul_builtin(magnitude(rhs), rhs < 0);
+        return *this;
+    }
+
     big_integer& operator<<=(int rhs);
     big_integer& operator>>=(int rhs);
 
@@ -113,7 +219,131 @@ public:
     friend bool operator<=(big_integer const& a, big_integer const& b);
     friend bool operator>=(big_integer const& a, big_integer const& b);
 
+    template <typename T>
+    friend if_builtin<T, big_integer> operator+(big_integer a, T b) {
+        return a += b;
+    }
+
+    template <typename T>
+    friend if_builtin<T, big_integer> operator+(T a, big_integer b) {
+        return b += a;
+    }
+
+    template <typename T>
+    friend if_builtin<T, big_integer> operator-(big_integer a, T b) {
+        return a -= b;
+    }
+
+    template <typename T>
+    friend if_builtin<T, big_integer> operator-(T a, big_integer b) {
+        return -(b -= a);
+    }
+
+    template <typename T>
+    friend if_builtin<T, big_integer> operator*(big_integer a, T b) {
+        return a *= b;
+    }
+
+    template <typename T>
+    friend if_builtin<T, big_integer> operator*(T a, big_integer b) {
+        return b *= a;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator==(big_integer const& a, T b) {
+        return a.cmp_builtin(magnitude(b), b < 0) == 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator!=(big_integer const& a, T b) {
+        return a.cmp_builtin(magnitude(b), b < 0) != 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator<(big_integer const& a, T b) {
+        return a.cmp_builtin(magnitude(b), b < 0) < 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator>(big_integer const& a, T b) {
+        return a.cmp_builtin(magnitude(b), b < 0) > 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator<=(big_integer const& a, T b) {
+        return a.cmp_builtin(magnitude(b), b < 0) <= 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator>=(big_integer const& a, T b) {
+        return a.cmp_builtin(magnitude(b), b < 0) >= 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator==(T a, big_integer const& b) {
+        return b.cmp_builtin(magnitude(a), a < 0) == 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator!=(T a, big_integer const& b) {
+        return b.cmp_builtin(magnitude(a), a < 0) != 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator<(T a, big_integer const& b) {
+        return b.cmp_builtin(magnitude(a), a < 0) > 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator>(T a, big_integer const& b) {
+        return b.cmp_builtin(magnitude(a), a < 0) < 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator<=(T a, big_integer const& b) {
+        return b.cmp_builtin(magnitude(a), a < 0) >= 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator>=(T a, big_integer const& b) {
+        return b.cmp_builtin(magnitude(a), a < 0) <= 0;
+    }
+
     friend std::string to_string(big_integer const& a);
+    friend std::string to_string(big_integer const& a, unsigned base);
+
+    friend int64_t to_int64(big_integer const& a);
+    friend uint64_t to_uint64(big_integer const& a);
+    friend int128_t to_int128(big_integer const& a);
+    friend uint128_t to_uint128(big_integer const& a);
+    friend int64_t saturate_int64(big_integer const& a);
+    friend uint64_t saturate_uint64(big_integer const& a);
+    friend int128_t saturate_int128(big_integer const& a);
+    friend uint128_t saturate_uint128(big_integer const& a);
+    friend double to_double(big_integer const& a);
+    friend long double to_long_double(big_integer const& a);
+    friend std::ostream& operator<<(std::ostream& s, big_integer const& a);
+    friend std::istream& operator>>(std::istream& s, big_integer& a);
+
+    friend struct std::hash<big_integer>;
+
+    friend big_integer pow(big_integer const& a, uint64_t n);
+    friend big_integer gcd(big_integer a, big_integer b);
+
+    friend struct big_integer_batch;
+    friend struct big_rational;
+    template <size_t Bits, bool Signed>
+    friend struct fixed_int;
+
+    // See primality.h
+    friend bool is_probable_prime(big_integer const& n, unsigned rounds);
+    friend big_integer next_prime(big_integer const& n);
+
+    // See serialization.h
+    friend std::vector<uint8_t> export_bytes(big_integer const& a, byte_order order);
+    friend big_integer import_bytes(uint8_t const* data, size_t size, byte_order order, bool negative);
+    friend std::vector<uint32_t> export_limbs(big_integer const& a);
+    friend big_integer import_limbs(uint32_t const* data, size_t size, bool negative);
 };
 
 big_integer operator+(big_integer a, big_integer const& b);
@@ -129,6 +359,39 @@ big_integer operator^(big_integer a, big_integer const& b);
 big_integer operator<<(big_integer a, int b);
 big_integer operator>>(big_integer a, int b);
 
-std::ostream& operator<<(std::ostream& s, big_integer const& a);
+// Lowercase digits, 2 <= base <= 36, linear time for the powers of two
+std::string to_string(big_integer const& a, unsigned base);
+
+// Conversions to the builtin types.
+// to_* throw std::overflow_error if the value is out of range, saturate_* clamp it to the range.
+int64_t to_int64(big_integer const& a);
+uint64_t to_uint64(big_integer const& a);
+int128_t to_int128(big_integer const& a);
+uint128_t to_uint128(big_integer const& a);
+
+int64_t saturate_int64(big_integer const& a);
+uint64_t saturate_uint64(big_integer const& a);
+int128_t saturate_int128(big_integer const& a);
+uint128_t saturate_uint128(big_integer const& a);
 
+// Correctly rounded (to nearest, ties to even), infinity if the value is too large
+double to_double(big_integer const& a);
+long double to_long_double(big_integer const& a);
 
+// Greatest common divisor, non-negative, gcd(0, 0) = 0
+big_integer gcd(big_integer a, big_integer b);
+
+// a^n, 0^0 = 1
+big_integer pow(big_integer const& a, uint64_t n);
+
+// Digits are written in blocks as they are converted, the width and fill of the stream are respected
+std::ostream& operator<<(std::ostream& s, big_integer const& a);
+// Reads an optional sign and decimal digits straight from the stream, sets failbit if there are no digits
+std::istream& operator>>(std::istream& s, big_integer& a);
+
+namespace std {
+    template <>
+    struct hash<big_integer> {
+        size_t operator()(big_integer const& a) const;
+    };
+}
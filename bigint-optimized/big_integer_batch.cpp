@@ -0,0 +1,269 @@
+#include "big_integer_batch.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// Helpful functions
+
+namespace {
+    using number_t = big_integer_batch::number_t;
+    using big_number_t = number_storage::big_number_t;
+
+    void check_sizes(big_integer_batch const& a, big_integer_batch const& b) {
+        if (a.size() != b.size()) {
+            throw std::invalid_argument("batches of different sizes");
+        }
+    }
+}
+
+// Private methods
+
+number_t* big_integer_batch::row(size_t j) {
+    return data_.data() + j * size_;
+}
+
+number_t const* big_integer_batch::row(size_t j) const {
+    return data_.data() + j * size_;
+}
+
+std::vector<number_t> big_integer_batch::sign_row() const {
+    std::vector<number_t> sign(size_);
+    number_t const* top = row(width_ - 1);
+    for (size_t i = 0; i != size_; ++i) {
+        sign[i] = -(top[i] >> 31);
+    }
+    return sign;
+}
+
+number_t const* big_integer_batch::row(size_t j, std::vector<number_t> const& sign) const {
+    return j < width_ ? row(j) : sign.data();
+}
+
+// Public methods
+
+big_integer_batch::big_integer_batch(size_t size, size_t width)
+        : size_(size), width_(std::max(width, static_cast<size_t>(1))), data_(size_ * width_)
+{}
+
+big_integer_batch::big_integer_batch(std::vector<big_integer> const& values, size_t width)
+        : big_integer_batch(values.size(), width) {
+    for (size_t i = 0; i != size_; ++i) {
+        set(i, values[i]);
+    }
+}
+
+size_t big_integer_batch::size() const {
+    return size_;
+}
+
+size_t big_integer_batch::width() const {
+    return width_;
+}
+
+big_integer big_integer_batch::get(size_t i) const {
+    big_integer res(0, width_);
+    for (size_t j = 0; j != width_; ++j) {
+        res.val_[j] = row(j)[i];
+    }
+    if (res.val_.back() >> 31) {
+        res.sign_ = true;
+        // Magnitude of a negative value : ~x + 1
+        for (auto& el : res.val_) {
+            el = ~el;
+        }
+        big_integer::add_long_short(res, 1);
+    }
+    res.clear_back();
+    return res;
+}
+
+void big_integer_batch::set(size_t i, big_integer const& value) {
+    size_t size = value.val_.size();
+    number_t high = value.val_.back();
+    // The magnitude must stay below 2^(32 * width - 1), -2^(32 * width - 1) is allowed as well
+    bool fits = size < width_ || (size == width_ && (high >> 31) == 0);
+    if (!fits && value.sign_ && size == width_ && high == (1u << 31)) {
+        fits = std::all_of(value.val_.begin(), value.val_.end() - 1, [](number_t x) { return x == 0; });
+    }
+    if (!fits) {
+        throw std::overflow_error("value doesn't fit into the batch width");
+    }
+    if (value.sign_) {
+        // Two's complement : ~(x - 1)
+        big_number_t borrow = 1;
+        for (size_t j = 0; j != width_; ++j) {
+            big_number_t cur = j < size ? value.val_[j] : 0;
+            big_number_t diff = cur - borrow;
+            borrow = cur < borrow;
+            row(j)[i] = ~static_cast<number_t>(diff);
+        }
+    } else {
+        for (size_t j = 0; j != width_; ++j) {
+            row(j)[i] = j < size ? value.val_[j] : 0;
+        }
+    }
+}
+
+std::vector<big_integer> big_integer_batch::to_vector() const {
+    std::vector<big_integer> res;
+    res.reserve(size_);
+    for (size_t i = 0; i != size_; ++i) {
+        res.push_back(get(i));
+    }
+    return res;
+}
+
+big_integer_batch add(big_integer_batch const& a, big_integer_batch const& b) {
+    check_sizes(a, b);
+    size_t n = a.size_;
+    big_integer_batch res(n, std::max(a.width_, b.width_) + 1);
+    std::vector<number_t> sign_a = a.sign_row();
+    std::vector<number_t> sign_b = b.sign_row();
+    std::vector<big_number_t> carry(n);
+    for (size_t j = 0; j != res.width_; ++j) {
+        number_t const* x = a.row(j, sign_a);
+        number_t const* y = b.row(j, sign_b);
+        number_t* r = res.row(j);
+        for (size_t i = 0; i != n; ++i) {
+            big_number_t cur = carry[i] + x[i] + y[i];
+            r[i] = static_cast<number_t>(cur);
+            carry[i] = cur >> 32;
+        }
+    }
+    return res;
+}
+
+big_integer_batch sub(big_integer_batch const& a, big_integer_batch const& b) {
+    check_sizes(a, b);
+    size_t n = a.size_;
+    big_integer_batch res(n, std::max(a.width_, b.width_) + 1);
+    std::vector<number_t> sign_a = a.sign_row();
+    std::vector<number_t> sign_b = b.sign_row();
+    // a - b = a + ~b + 1
+    std::vector<big_number_t> carry(n, 1);
+    for (size_t j = 0; j != res.width_; ++j) {
+        number_t const* x = a.row(j, sign_a);
+        number_t const* y = b.row(j, sign_b);
+        number_t* r = res.row(j);
+        for (size_t i = 0; i != n; ++i) {
+            big_number_t cur = carry[i] + x[i] + static_cast<number_t>(~y[i]);
+            r[i] = static_cast<number_t>(cur);
+            carry[i] = cur >> 32;
+        }
+    }
+    return res;
+}
+
+big_integer_batch mul(big_integer_batch const& a, big_integer_batch const& b) {
+    check_sizes(a, b);
+    size_t n = a.size_;
+    size_t wa = a.width_;
+    size_t wb = b.width_;
+    big_integer_batch res(n, wa + wb);
+    std::vector<big_number_t> carry(n);
+
+    // Unsigned product of the two's complement representations
+    for (size_t ja = 0; ja != wa; ++ja) {
+        std::fill(carry.begin(), carry.end(), 0);
+        number_t const* x = a.row(ja);
+        for (size_t jb = 0; jb != wb; ++jb) {
+            number_t const* y = b.row(jb);
+            number_t* r = res.row(ja + jb);
+            for (size_t i = 0; i != n; ++i) {
+                big_number_t cur = r[i] + static_cast<big_number_t>(x[i]) * y[i] + carry[i];
+                r[i] = static_cast<number_t>(cur);
+                carry[i] = cur >> 32;
+            }
+        }
+        number_t* r = res.row(ja + wb);
+        for (size_t i = 0; i != n; ++i) {
+            r[i] = static_cast<number_t>(carry[i]);
+        }
+    }
+
+    // A negative a is read as a + 2^(32 * wa), so b * 2^(32 * wa) is subtracted, and vice versa
+    std::vector<number_t> mask_a = a.sign_row();
+    std::vector<number_t> mask_b = b.sign_row();
+    auto correct = [&](big_integer_batch const& other, std::vector<number_t> const& mask, size_t shift) {
+        std::vector<number_t> borrow(n);
+        std::vector<number_t> zero(n);
+        for (size_t j = shift; j != wa + wb; ++j) {
+            number_t* r = res.row(j);
+            number_t const* y = j - shift < other.width_ ? other.row(j - shift) : zero.data();
+            for (size_t i = 0; i != n; ++i) {
+                number_t sub = y[i] & mask[i];
+                number_t cur = r[i];
+                r[i] = cur - sub - borrow[i];
+                borrow[i] = cur < sub || (cur == sub && borrow[i]);
+            }
+        }
+    };
+    correct(b, mask_a, wa);
+    correct(a, mask_b, wb);
+    return res;
+}
+
+std::vector<int> compare(big_integer_batch const& a, big_integer_batch const& b) {
+    check_sizes(a, b);
+    size_t n = a.size_;
+    size_t width = std::max(a.width_, b.width_);
+    std::vector<number_t> sign_a = a.sign_row();
+    std::vector<number_t> sign_b = b.sign_row();
+    std::vector<int> res(n);
+    // The top limb decides by its signed value, the others by the unsigned one
+    number_t const* x = a.row(width - 1, sign_a);
+    number_t const* y = b.row(width - 1, sign_b);
+    for (size_t i = 0; i != n; ++i) {
+        auto sx = static_cast<int32_t>(x[i]);
+        auto sy = static_cast<int32_t>(y[i]);
+        res[i] = (sx > sy) - (sx < sy);
+    }
+    for (size_t j = width - 1; j != 0; ) {
+        --j;
+        x = a.row(j, sign_a);
+        y = b.row(j, sign_b);
+        for (size_t i = 0; i != n; ++i) {
+            int cur = (x[i] > y[i]) - (x[i] < y[i]);
+            res[i] = res[i] != 0 ? res[i] : cur;
+        }
+    }
+    return res;
+}
+
+big_integer big_integer_batch::sum() const {
+    // Every element is (unsigned representation) - 2^(32 * width) * (sign bit),
+    // the unsigned parts are summed up row by row in 64-bit accumulators.
+    constexpr size_t CHUNK = static_cast<size_t>(1) << 31;
+    big_integer res(0, width_ + 3);
+    big_integer negative(0, width_ + 3);
+    for (size_t lo = 0; lo < size_; lo += CHUNK) {
+        size_t hi = std::min(size_, lo + CHUNK);
+        big_number_t carry = 0;
+        for (size_t j = 0; j != width_ + 3; ++j) {
+            big_number_t acc = 0;
+            if (j < width_) {
+                number_t const* r = row(j);
+                for (size_t i = lo; i != hi; ++i) {
+                    acc += r[i];
+                }
+            }
+            // acc < 2^63, so adding it to the carry can't overflow
+            big_number_t low = (carry & 0xFFFFFFFF) + (acc & 0xFFFFFFFF) + res.val_[j];
+            res.val_[j] = static_cast<number_t>(low);
+            carry = (carry >> 32) + (acc >> 32) + (low >> 32);
+        }
+        number_t const* top = row(width_ - 1);
+        big_number_t count = 0;
+        for (size_t i = lo; i != hi; ++i) {
+            count += top[i] >> 31;
+        }
+        big_number_t low = static_cast<big_number_t>(negative.val_[width_]) + (count & 0xFFFFFFFF);
+        negative.val_[width_] = static_cast<number_t>(low);
+        big_number_t high = static_cast<big_number_t>(negative.val_[width_ + 1]) + (count >> 32) + (low >> 32);
+        negative.val_[width_ + 1] = static_cast<number_t>(high);
+        negative.val_[width_ + 2] += static_cast<number_t>(high >> 32);
+    }
+    res.clear_back();
+    negative.clear_back();
+    return res -= negative;
+}
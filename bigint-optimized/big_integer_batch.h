@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "big_integer.h"
+
+// Many integers of the same width (in limbs) stored limb-major : limb j of
+// element i is at data[j * size + i]. Elementwise operations then run over
+// contiguous arrays without branches on the representation and get
+// vectorized by the compiler. Elements are kept in two's complement.
+struct big_integer_batch {
+    using number_t = number_storage::number_t;
+
+    big_integer_batch(size_t size, size_t width);
+    // Throws std::overflow_error if a value doesn't fit into `width` limbs
+    big_integer_batch(std::vector<big_integer> const& values, size_t width);
+
+    size_t size() const;
+    size_t width() const;
+
+    big_integer get(size_t i) const;
+    void set(size_t i, big_integer const& value);
+    std::vector<big_integer> to_vector() const;
+
+    // Elementwise operations, the results are exact : add and sub widen by
+    // one limb, mul returns the sum of the widths.
+    // Throw std::invalid_argument if the sizes differ.
+    friend big_integer_batch add(big_integer_batch const& a, big_integer_batch const& b);
+    friend big_integer_batch sub(big_integer_batch const& a, big_integer_batch const& b);
+    friend big_integer_batch mul(big_integer_batch const& a, big_integer_batch const& b);
+
+    // Elementwise sign of a[i] - b[i] : -1, 0 or 1
+    friend std::vector<int> compare(big_integer_batch const& a, big_integer_batch const& b);
+
+    // Sum of all elements
+    big_integer sum() const;
+
+ private:
+    size_t size_;
+    size_t width_;
+    std::vector<number_t> data_;
+
+    number_t* row(size_t j);
+    number_t const* row(size_t j) const;
+
+    // Limb j of every element, the sign is extended beyond the width
+    std::vector<number_t> sign_row() const;
+    number_t const* row(size_t j, std::vector<number_t> const& sign) const;
+};
@@ -4,11 +4,23 @@
 #include <random>
 #include <vector>
 #include <utility>
+#include <thread>
+#include <unordered_set>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <limits>
 #include <gtest/gtest.h>
 
 #include "number_storage.h"
 #include "big_integer.h"
 #include "big_integer_gmp.h"
+#include "combinatorics.h"
+#include "primality.h"
+#include "big_integer_batch.h"
+#include "fixed_int.h"
+#include "serialization.h"
+#include "big_rational.h"
 
 TEST(correctness, two_plus_two) {
   EXPECT_EQ(big_integer(4), big_integer(2) + big_integer(2));
@@ -816,3 +828,753 @@ TEST(correctness_twos_complement, all_ones) {
 
   EXPECT_EQ(to_string(gmp_ans), to_string(your_ans));
 }
+
+TEST(correctness, pow_small) {
+  EXPECT_EQ(1, pow(big_integer(0), 0));
+  EXPECT_EQ(0, pow(big_integer(0), 5));
+  EXPECT_EQ(1, pow(big_integer(-1), 10));
+  EXPECT_EQ(-1, pow(big_integer(-1), 11));
+  EXPECT_EQ(1024, pow(big_integer(2), 10));
+  EXPECT_EQ(-2187, pow(big_integer(-3), 7));
+  EXPECT_EQ(big_integer("515377520732011331036461129765621272702107522001"), pow(big_integer(3), 100));
+}
+
+TEST(correctness, pow_power_of_two) {
+  EXPECT_EQ(big_integer(1) << 4000, pow(big_integer(16), 1000));
+  EXPECT_EQ(-(big_integer(1) << 3003), pow(-(big_integer(1) << 91), 33));
+  EXPECT_EQ(big_integer(1) << 3036, pow(-(big_integer(1) << 92), 33) * -1);
+}
+
+TEST(correctness, pow_randomized) {
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer a = rand_big(itn);
+    if (rand() % 2) {
+      a = -a;
+    }
+    uint64_t n = rand() % 50;
+    big_integer expected = 1;
+    for (uint64_t i = 0; i != n; ++i) {
+      expected *= a;
+    }
+    EXPECT_EQ(expected, pow(a, n));
+  }
+}
+
+TEST(correctness, mul_self) {
+  big_integer a = rand_big(30);
+  big_integer b = a;
+  big_integer c = a;
+  c *= b;
+  a *= a;
+  EXPECT_EQ(c, a);
+}
+
+TEST(correctness, factorial) {
+  big_integer expected = 1;
+  for (uint32_t n = 0; n != 300; ++n) {
+    if (n != 0) {
+      expected *= static_cast<int>(n);
+    }
+    ASSERT_EQ(expected, factorial(n)) << n;
+  }
+  EXPECT_EQ(big_integer("2432902008176640000"), factorial(20));
+}
+
+TEST(correctness, factorial_threads) {
+  EXPECT_EQ(factorial(20000), factorial(20000, 4));
+}
+
+TEST(correctness, binomial) {
+  std::vector<big_integer> row(1, 1);
+  for (uint32_t n = 1; n != 120; ++n) {
+    std::vector<big_integer> next(n + 1, 1);
+    for (uint32_t k = 1; k != n; ++k) {
+      next[k] = row[k - 1] + row[k];
+    }
+    row.swap(next);
+    for (uint32_t k = 0; k <= n; ++k) {
+      ASSERT_EQ(row[k], binomial(n, k)) << n << " " << k;
+    }
+  }
+  EXPECT_EQ(0, binomial(5, 6));
+  EXPECT_EQ(factorial(3000) / factorial(1000) / factorial(2000), binomial(3000, 1000, 4));
+}
+
+TEST(correctness, primorial) {
+  EXPECT_EQ(1, primorial(0));
+  EXPECT_EQ(1, primorial(1));
+  EXPECT_EQ(2, primorial(2));
+  EXPECT_EQ(30, primorial(6));
+  EXPECT_EQ(big_integer("614889782588491410"), primorial(50));
+
+  big_integer expected = 1;
+  for (int p = 2; p <= 5000; ++p) {
+    bool prime = true;
+    for (int d = 2; d * d <= p; ++d) {
+      prime = prime && p % d != 0;
+    }
+    if (prime) {
+      expected *= p;
+    }
+  }
+  EXPECT_EQ(expected, primorial(5000, 4));
+}
+
+TEST(correctness, mod_short_large_remainder) {
+  big_integer a = (big_integer(1) << 64) - 1;
+  big_integer b = (big_integer(1) << 32) - 5;
+  EXPECT_EQ(a - a / b * b, a % b);
+}
+
+namespace {
+bool is_prime_naive(int n) {
+  if (n < 2) {
+    return false;
+  }
+  for (int64_t d = 2; d * d <= n; ++d) {
+    if (n % d == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+TEST(correctness, is_probable_prime_small) {
+  for (int n = -10; n != 20000; ++n) {
+    ASSERT_EQ(is_prime_naive(n), is_probable_prime(n)) << n;
+  }
+  for (int n = 2147483000; n != 2147483647; ++n) {
+    ASSERT_EQ(is_prime_naive(n), is_probable_prime(n)) << n;
+  }
+}
+
+TEST(correctness, is_probable_prime_pseudoprimes) {
+  // Carmichael numbers and strong pseudoprimes to base 2
+  for (char const* s : {"561", "41041", "825265", "2047", "3215031751", "1194649", "12327121",
+                        "3825123056546413051", "318665857834031151167461"}) {
+    EXPECT_FALSE(is_probable_prime(big_integer(s))) << s;
+    EXPECT_FALSE(is_probable_prime(big_integer(s), 5)) << s;
+  }
+}
+
+TEST(correctness, is_probable_prime_large) {
+  big_integer m127 = (big_integer(1) << 127) - 1;
+  big_integer m521 = (big_integer(1) << 521) - 1;
+  big_integer m607 = (big_integer(1) << 607) - 1;
+  EXPECT_TRUE(is_probable_prime(m127));
+  EXPECT_TRUE(is_probable_prime(m521, 10));
+  EXPECT_TRUE(is_probable_prime(m607));
+  EXPECT_FALSE(is_probable_prime((big_integer(1) << 523) - 1));
+  EXPECT_FALSE(is_probable_prime(m127 * m521));
+  EXPECT_FALSE(is_probable_prime(m521 * m521));
+  EXPECT_FALSE(is_probable_prime(-m127));
+}
+
+TEST(correctness, next_prime) {
+  EXPECT_EQ(2, next_prime(-5));
+  EXPECT_EQ(2, next_prime(1));
+  EXPECT_EQ(3, next_prime(2));
+  for (int n = 0; n != 10000; ++n) {
+    int expected = n + 1;
+    while (!is_prime_naive(expected)) {
+      ++expected;
+    }
+    ASSERT_EQ(expected, next_prime(n)) << n;
+  }
+  EXPECT_EQ((big_integer(1) << 127) - 1, next_prime((big_integer(1) << 127) - 25));
+  EXPECT_EQ((big_integer(1) << 64) + 13, next_prime(big_integer(1) << 64));
+}
+
+TEST(correctness, shr_rounding) {
+  EXPECT_EQ(-2, big_integer(-4) >> 1);
+  EXPECT_EQ(-3, big_integer(-5) >> 1);
+  EXPECT_EQ(-1, big_integer(-5) >> 100);
+  EXPECT_EQ(0, big_integer(5) >> 100);
+  EXPECT_EQ(-(big_integer(1) << 36), -(big_integer(1) << 100) >> 64);
+}
+
+TEST(correctness, mul_karatsuba) {
+  big_integer a = rand_big(700);
+  big_integer b = rand_big(500);
+  big_integer c = rand_big(70);
+  EXPECT_EQ(a * b, b * a);
+  EXPECT_EQ((a + b) * (a - b), a * a - b * b);
+  EXPECT_EQ(a * (b + c), a * b + a * c);
+  EXPECT_EQ(-a * c, a * -c);
+  EXPECT_EQ(b, a * b / a);
+  EXPECT_EQ(pow(a, 3), a * a * a);
+}
+
+TEST(correctness, mul_parallel) {
+  big_integer a = rand_big(3000);
+  big_integer b = rand_big(2000);
+  big_integer c = rand_big(200);
+  big_integer ab = a * b;
+  big_integer ac = a * c;
+  big_integer aa = a * a;
+
+  big_integer::set_mul_threads(4, 64);
+  EXPECT_EQ(ab, a * b);
+  EXPECT_EQ(ac, a * c);
+  EXPECT_EQ(aa, a * a);
+  EXPECT_EQ(factorial(20000), factorial(20000, 3));
+  big_integer::set_mul_threads(1);
+  EXPECT_EQ(ab, a * b);
+}
+
+namespace {
+std::vector<big_integer> rand_values(size_t count, size_t bits) {
+  std::vector<big_integer> res;
+  for (size_t i = 0; i != count; ++i) {
+    big_integer x = rand_big(rand() % (bits / 31));
+    x >>= static_cast<int>(rand() % 31);
+    res.push_back(rand() % 2 ? -x : x);
+  }
+  return res;
+}
+}
+
+TEST(correctness, batch_conversions) {
+  std::vector<big_integer> values = rand_values(100, 128);
+  values.push_back((big_integer(1) << 127) - 1);
+  values.push_back(-(big_integer(1) << 127));
+  values.push_back(0);
+  values.push_back(-1);
+  big_integer_batch batch(values, 4);
+  EXPECT_EQ(values, batch.to_vector());
+  EXPECT_THROW(batch.set(0, big_integer(1) << 127), std::overflow_error);
+  EXPECT_THROW(batch.set(0, -(big_integer(1) << 127) - 1), std::overflow_error);
+}
+
+TEST(correctness, batch_arithmetic) {
+  std::vector<big_integer> a = rand_values(1000, 256);
+  std::vector<big_integer> b = rand_values(1000, 64);
+  big_integer_batch ba(a, 9);
+  big_integer_batch bb(b, 3);
+
+  std::vector<big_integer> sum = add(ba, bb).to_vector();
+  std::vector<big_integer> diff = sub(bb, ba).to_vector();
+  std::vector<big_integer> prod = mul(ba, bb).to_vector();
+  std::vector<int> cmp = compare(ba, bb);
+  big_integer total = 0;
+  for (size_t i = 0; i != a.size(); ++i) {
+    ASSERT_EQ(a[i] + b[i], sum[i]);
+    ASSERT_EQ(b[i] - a[i], diff[i]);
+    ASSERT_EQ(a[i] * b[i], prod[i]);
+    ASSERT_EQ(a[i] < b[i] ? -1 : a[i] > b[i] ? 1 : 0, cmp[i]);
+    total += a[i];
+  }
+  EXPECT_EQ(total, ba.sum());
+
+  std::vector<int> self = compare(ba, ba);
+  EXPECT_TRUE(std::all_of(self.begin(), self.end(), [](int x) { return x == 0; }));
+  EXPECT_THROW(add(ba, big_integer_batch(10, 2)), std::invalid_argument);
+}
+
+TEST(correctness, fixed_int_simple) {
+  fixed_int<128> a = 2;
+  EXPECT_EQ(4, a + 2);
+  EXPECT_EQ(-1, a - 3);
+  EXPECT_EQ("-1", to_string(fixed_int<128>(-1)));
+  EXPECT_EQ("340282366920938463463374607431768211455", to_string(fixed_uint<128>(-1)));
+  EXPECT_EQ("-170141183460469231731687303715884105728", to_string(fixed_int<128>(1) << 127));
+  EXPECT_EQ(fixed_int<128>(1) << 127, (fixed_int<128>(1) << 127) - 1 + 1);
+  EXPECT_LT(fixed_int<128>(1) << 127, 0);
+  EXPECT_GT(fixed_uint<128>(1) << 127, 0u);
+  EXPECT_EQ(-1, fixed_int<128>(-5) >> 10);
+  EXPECT_EQ(1, fixed_uint<128>(-5) >> 127);
+  EXPECT_EQ(fixed_int<256>("-123456789012345678901234567890"),
+            fixed_int<256>("-123456789012345678901234567890123") / 1000);
+  EXPECT_EQ(-123, fixed_int<256>("-123456789012345678901234567890123") % 1000);
+  EXPECT_THROW(fixed_int<64>(1) / 0, std::domain_error);
+  EXPECT_THROW(fixed_int<64>("12a"), std::runtime_error);
+}
+
+namespace {
+template <size_t Bits, bool Signed>
+big_integer wrap(big_integer x) {
+  big_integer mod = big_integer(1) << Bits;
+  x %= mod;
+  if (x < 0) {
+    x += mod;
+  }
+  if (Signed && x >= mod / 2) {
+    x -= mod;
+  }
+  return x;
+}
+
+template <size_t Bits, bool Signed>
+void check_fixed_int() {
+  using fixed = fixed_int<Bits, Signed>;
+  auto w = [](big_integer const& x) { return wrap<Bits, Signed>(x); };
+  for (size_t itn = 0; itn != 200; ++itn) {
+    big_integer a = w(rand_big(rand() % (Bits / 31 + 2)) * (rand() % 2 ? 1 : -1));
+    big_integer b = w(rand_big(rand() % (Bits / 31 + 2)) * (rand() % 2 ? 1 : -1));
+    if (b == 0) {
+      b = 1;
+    }
+    int shift = rand() % Bits;
+    fixed fa(a);
+    fixed fb(b);
+    ASSERT_EQ(a, big_integer(fa));
+    ASSERT_EQ(to_string(a), to_string(fa));
+    ASSERT_EQ(fa, fixed(to_string(a)));
+    ASSERT_EQ(w(a + b), big_integer(fa + fb));
+    ASSERT_EQ(w(a - b), big_integer(fa - fb));
+    ASSERT_EQ(w(a * b), big_integer(fa * fb));
+    ASSERT_EQ(a / b, big_integer(fa / fb));
+    ASSERT_EQ(a % b, big_integer(fa % fb));
+    ASSERT_EQ(w(a & b), big_integer(fa & fb));
+    ASSERT_EQ(w(a | b), big_integer(fa | fb));
+    ASSERT_EQ(w(a ^ b), big_integer(fa ^ fb));
+    ASSERT_EQ(w(a << shift), big_integer(fa << shift));
+    ASSERT_EQ(a < b, fa < fb);
+    ASSERT_EQ(a == b, fa == fb);
+    ASSERT_EQ(a >> shift, big_integer(fa >> shift));
+  }
+}
+}
+
+TEST(correctness_random, fixed_int) {
+  check_fixed_int<64, true>();
+  check_fixed_int<128, true>();
+  check_fixed_int<128, false>();
+  check_fixed_int<256, true>();
+  check_fixed_int<1024, true>();
+  check_fixed_int<1024, false>();
+}
+
+TEST(correctness, hash) {
+  std::hash<big_integer> h;
+  big_integer a = rand_big(50);
+  EXPECT_EQ(h(a), h(big_integer(to_string(a))));
+  EXPECT_EQ(h(big_integer(0)), h(-big_integer(0)));
+  EXPECT_NE(h(a), h(-a));
+
+  std::unordered_set<big_integer> set;
+  for (int i = -1000; i != 1000; ++i) {
+    set.insert(big_integer(i) * a);
+  }
+  EXPECT_EQ(2000u, set.size());
+  EXPECT_EQ(1u, set.count(a * -1000));
+  EXPECT_EQ(0u, set.count(a * 1000));
+}
+
+TEST(correctness, hash_cache) {
+  std::hash<big_integer> h;
+  big_integer a = rand_big(50);
+  big_integer b = a;
+  size_t hash = h(a);
+  EXPECT_EQ(hash, h(b));
+  EXPECT_TRUE(a == b);
+
+  b += 1;
+  EXPECT_NE(hash, h(b));
+  EXPECT_EQ(h(big_integer(to_string(b))), h(b));
+  EXPECT_EQ(hash, h(a));
+  a += 1;
+  EXPECT_EQ(h(b), h(a));
+  EXPECT_TRUE(a == b);
+  EXPECT_FALSE(a != b);
+
+  big_integer c = a;
+  c >>= 32;
+  EXPECT_EQ(h(a >> 32), h(c));
+}
+
+TEST(correctness, hash_cache_threads) {
+  std::hash<big_integer> h;
+  big_integer a = rand_big(50);
+  for (int r = 0; r != 200; ++r) {
+    big_integer const value = a * (r + 1);
+    big_integer const shorter = value;
+    size_t expected = h(big_integer(to_string(value)));
+    std::vector<std::thread> threads;
+    std::vector<size_t> mismatches(2);
+    for (size_t t = 0; t != 2; ++t) {
+      threads.emplace_back([&, t] {
+        for (int i = 0; i != 100; ++i) {
+          if (h(value) != expected || h(shorter) != expected) {
+            ++mismatches[t];
+          }
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    ASSERT_EQ(0u, mismatches[0] + mismatches[1]) << r;
+  }
+}
+
+TEST(correctness, serialization_bytes) {
+  big_integer a("1108152157446");  // 0x0102_0304_0506
+  std::vector<uint8_t> little = {6, 5, 4, 3, 2, 1};
+  std::vector<uint8_t> big = {1, 2, 3, 4, 5, 6};
+  EXPECT_EQ(little, export_bytes(a));
+  EXPECT_EQ(big, export_bytes(-a, byte_order::big_endian));
+  EXPECT_EQ(a, import_bytes(big.data(), big.size(), byte_order::big_endian));
+  EXPECT_EQ(-a, import_bytes(little.data(), little.size(), byte_order::little_endian, true));
+  EXPECT_TRUE(export_bytes(0).empty());
+  EXPECT_EQ(0, import_bytes(nullptr, 0, byte_order::little_endian, true));
+
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer b = rand_big(itn % 100 + 1);
+    std::vector<uint8_t> bytes = export_bytes(b, byte_order::big_endian);
+    EXPECT_EQ(b, import_bytes(bytes.data(), bytes.size(), byte_order::big_endian));
+    std::vector<uint32_t> limbs = export_limbs(b);
+    EXPECT_EQ(-b, import_limbs(limbs.data(), limbs.size(), true));
+  }
+}
+
+TEST(correctness, serialization_stream) {
+  std::vector<big_integer> v = {0, 1, -1, 127, -128, big_integer(1) << 1000};
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    v.push_back(rand() % 2 ? rand_big(itn % 100 + 1) : -rand_big(itn % 100 + 1));
+  }
+  std::stringstream s;
+  write_binary(s, v[5]);
+  write_binary(s, v);
+  EXPECT_EQ(v[5], read_binary(s));
+  EXPECT_EQ(v, read_binary_vector(s));
+  EXPECT_THROW(read_binary(s), std::runtime_error);
+
+  std::stringstream truncated;
+  write_binary(truncated, v[5]);
+  std::string data = truncated.str();
+  truncated.str(data.substr(0, data.size() - 1));
+  EXPECT_THROW(read_binary(truncated), std::runtime_error);
+}
+
+TEST(correctness, serialization_malformed) {
+  // A huge length with no body fails as a truncated stream, without allocating it
+  std::stringstream huge(std::string("\xff\xff\xff\xff\xff\xff\xff\xff\x7f", 9));
+  EXPECT_THROW(read_binary(huge), std::runtime_error);
+  std::stringstream large(std::string("\xff\xff\xff\xff\x01", 5));
+  EXPECT_THROW(read_binary(large), std::runtime_error);
+
+  // The 10th byte of a varint may only carry bit 63
+  std::stringstream overlong(std::string("\x80\x80\x80\x80\x80\x80\x80\x80\x80\x02", 10));
+  EXPECT_THROW(read_binary(overlong), std::runtime_error);
+  std::stringstream too_many(std::string("\x80\x80\x80\x80\x80\x80\x80\x80\x80\x81\x00", 11));
+  EXPECT_THROW(read_binary(too_many), std::runtime_error);
+  std::stringstream vector_size(std::string("\x80\x80\x80\x80\x80\x80\x80\x80\x80\x7f", 10));
+  EXPECT_THROW(read_binary_vector(vector_size), std::runtime_error);
+}
+
+TEST(correctness, mapped_storage) {
+  big_integer a = rand_big(1500);
+  big_integer b = -rand_big(600);
+  big_integer product = a * b;
+  big_integer square = a * a;
+  big_integer sum = a + b;
+
+  for (auto backend : {storage_backend::temp_file, storage_backend::anonymous_mapping}) {
+    number_storage::set_storage_backend(backend, 256);
+    big_integer c = big_integer(to_string(a));
+    big_integer d = big_integer(to_string(b));
+    EXPECT_EQ(product, c * d);
+    EXPECT_EQ(product, d * c);
+    EXPECT_EQ(square, c * c);
+    c += d;
+    EXPECT_EQ(sum, c);
+    EXPECT_EQ(product / d, a);
+    EXPECT_TRUE(number_storage(256).is_mapped());
+    EXPECT_FALSE(number_storage(100).is_mapped());
+  }
+  number_storage::set_storage_backend(storage_backend::heap, 0);
+}
+
+TEST(correctness, stream_output) {
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer a = rand_big(itn % 300 + 1);
+    if (rand() % 2) {
+      a = -a;
+    }
+    std::ostringstream s;
+    s << a;
+    EXPECT_EQ(to_string(big_integer_gmp(to_string(a))), s.str());
+  }
+
+  std::ostringstream s;
+  s << std::setw(6) << big_integer(-42) << '|' << std::left << std::setfill('.') << std::setw(5)
+    << big_integer(1000000000) << '|' << std::setw(4) << big_integer(7) << '|' << big_integer(0);
+  EXPECT_EQ("   -42|1000000000|7...|0", s.str());
+}
+
+TEST(correctness, stream_input) {
+  big_integer a = rand_big(200);
+  std::stringstream s;
+  s << a << "  -" << a << "\n+00012 0 -0 x";
+  big_integer b, c, d, e, f;
+  s >> b >> c >> d >> e >> f;
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(-a, c);
+  EXPECT_EQ(12, d);
+  EXPECT_EQ(0, e);
+  EXPECT_EQ(0, f);
+  EXPECT_FALSE(s.fail());
+
+  s >> b;
+  EXPECT_TRUE(s.fail());
+  EXPECT_EQ(a, b);
+
+  std::istringstream eof("123456789012345678901234567890");
+  eof >> b;
+  EXPECT_EQ(big_integer("123456789012345678901234567890"), b);
+  EXPECT_TRUE(eof.eof());
+  EXPECT_FALSE(eof.fail());
+}
+
+TEST(correctness, radix_simple) {
+  EXPECT_EQ("ff", to_string(big_integer(255), 16));
+  EXPECT_EQ("-100000000", to_string(-(big_integer(1) << 32), 16));
+  EXPECT_EQ("0", to_string(big_integer(0), 2));
+  EXPECT_EQ("0", to_string(big_integer(0), 7));
+  EXPECT_EQ("-z", to_string(big_integer(-35), 36));
+  EXPECT_EQ("1012", to_string(big_integer(32), 3));
+  EXPECT_EQ(big_integer("-3735928559"), big_integer("-DeadBeef", 16));
+  EXPECT_EQ(big_integer(1) << 100, big_integer("1" + std::string(20, '0'), 32));
+  EXPECT_EQ(0, big_integer("-000", 8));
+  EXPECT_THROW(big_integer("12", 1), std::invalid_argument);
+  EXPECT_THROW(big_integer("19", 8), std::runtime_error);
+  EXPECT_THROW(big_integer(""), std::runtime_error);
+  EXPECT_THROW(big_integer("-"), std::runtime_error);
+  EXPECT_THROW(big_integer("-", 16), std::runtime_error);
+  EXPECT_THROW(fixed_int<64>(""), std::runtime_error);
+  EXPECT_THROW(fixed_int<64>("-"), std::runtime_error);
+  EXPECT_THROW(to_string(big_integer(1), 37), std::invalid_argument);
+}
+
+TEST(correctness_random, radix) {
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer a = rand_big(itn % 50 + 1);
+    if (rand() % 2) {
+      a = -a;
+    }
+    mpz_t b;
+    mpz_init_set_str(b, to_string(a).c_str(), 10);
+    for (unsigned base = 2; base <= 36; ++base) {
+      std::string s = to_string(a, base);
+      char* expected = mpz_get_str(nullptr, static_cast<int>(base), b);
+      EXPECT_EQ(std::string(expected), s);
+      free(expected);
+      EXPECT_EQ(a, big_integer(s, base));
+    }
+    mpz_clear(b);
+  }
+}
+
+TEST(correctness, builtin_constructors) {
+  EXPECT_EQ(big_integer("4294967295"), big_integer(UINT32_MAX));
+  EXPECT_EQ(big_integer("-9223372036854775808"), big_integer(INT64_MIN));
+  EXPECT_EQ(big_integer("18446744073709551615"), big_integer(UINT64_MAX));
+  EXPECT_EQ(big_integer("-9223372036854775807"), big_integer(-9223372036854775807ll));
+  EXPECT_EQ(big_integer("340282366920938463463374607431768211455"), big_integer(~static_cast<uint128_t>(0)));
+  EXPECT_EQ(-(big_integer(1) << 127), big_integer(static_cast<int128_t>(static_cast<uint128_t>(1) << 127)));
+  EXPECT_EQ(0, big_integer(0ul));
+
+  EXPECT_EQ(-2, big_integer(-2.9));
+  EXPECT_EQ(0, big_integer(0.75));
+  EXPECT_EQ(0, big_integer(-0.5));
+  EXPECT_EQ(big_integer(1) << 1000, big_integer(std::ldexp(1.0, 1000)));
+  EXPECT_EQ(big_integer(3) << 70, big_integer(std::ldexp(3.0L, 70)));
+  EXPECT_EQ(big_integer("123456789012345678"), big_integer(123456789012345678.0L));
+  EXPECT_THROW(big_integer(std::numeric_limits<double>::infinity()), std::invalid_argument);
+  EXPECT_THROW(big_integer(std::nan("")), std::invalid_argument);
+}
+
+TEST(correctness, builtin_conversions) {
+  EXPECT_EQ(INT64_MIN, to_int64(big_integer(INT64_MIN)));
+  EXPECT_EQ(INT64_MAX, to_int64(big_integer(INT64_MAX)));
+  EXPECT_THROW(to_int64(big_integer(INT64_MAX) + 1), std::overflow_error);
+  EXPECT_THROW(to_uint64(big_integer(-1)), std::overflow_error);
+  EXPECT_EQ(UINT64_MAX, to_uint64(big_integer(UINT64_MAX)));
+  EXPECT_TRUE(to_int128(-(big_integer(1) << 127)) == static_cast<int128_t>(static_cast<uint128_t>(1) << 127));
+  EXPECT_THROW(to_int128(big_integer(1) << 127), std::overflow_error);
+  EXPECT_TRUE(to_uint128(big_integer(~static_cast<uint128_t>(0))) == ~static_cast<uint128_t>(0));
+
+  EXPECT_EQ(INT64_MAX, saturate_int64(big_integer(1) << 100));
+  EXPECT_EQ(INT64_MIN, saturate_int64(-(big_integer(1) << 64)));
+  EXPECT_EQ(0u, saturate_uint64(big_integer(-5)));
+  EXPECT_EQ(42u, saturate_uint64(big_integer(42)));
+  EXPECT_TRUE(saturate_uint128(big_integer(1) << 200) == ~static_cast<uint128_t>(0));
+  EXPECT_TRUE(saturate_int128(big_integer(-1)) == -1);
+
+  // Ties go to the even mantissa
+  EXPECT_EQ(std::ldexp(1.0, 63), to_double((big_integer(1) << 63) + (1 << 10)));
+  EXPECT_EQ(std::ldexp(1.0, 63) + 4096, to_double((big_integer(1) << 63) + (1 << 10) * 3));
+  EXPECT_EQ(std::ldexp(1.0, 63) + 2048, to_double((big_integer(1) << 63) + (1 << 10) + 1));
+  EXPECT_EQ(0.0, to_double(big_integer(0)));
+  EXPECT_EQ(-1.0, to_double(big_integer(-1)));
+  EXPECT_EQ(std::numeric_limits<double>::infinity(), to_double(big_integer(1) << 1024));
+  EXPECT_EQ(-std::numeric_limits<long double>::infinity(), to_long_double(-(big_integer(1) << 20000)));
+}
+
+TEST(correctness_random, builtin_conversions) {
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer a = rand_big(itn % 40 + 1) >> static_cast<int>(rand() % 32);
+    if (rand() % 2) {
+      a = -a;
+    }
+    std::string s = to_string(a);
+    EXPECT_EQ(std::strtod(s.c_str(), nullptr), to_double(a));
+    EXPECT_EQ(std::strtold(s.c_str(), nullptr), to_long_double(a));
+    EXPECT_EQ(to_double(a), to_double(big_integer(to_double(a))));
+
+    int64_t x = static_cast<int64_t>(static_cast<uint64_t>(rand()) << 33 ^ static_cast<uint64_t>(rand()) << 2);
+    EXPECT_EQ(x, to_int64(big_integer(x)));
+    EXPECT_EQ(std::to_string(x), to_string(big_integer(x)));
+  }
+}
+
+TEST(correctness, builtin_operands) {
+  big_integer a = big_integer(1) << 64;
+  EXPECT_TRUE(a > UINT64_MAX);
+  EXPECT_TRUE(-a < INT64_MIN);
+  EXPECT_TRUE(a - 1 == UINT64_MAX);
+  EXPECT_TRUE(UINT64_MAX == a - 1u);
+  EXPECT_TRUE(0 == big_integer(0));
+  EXPECT_TRUE(big_integer(-5) < 0);
+  EXPECT_TRUE(-5 < big_integer(-4));
+  EXPECT_TRUE(big_integer(-5) != -4l);
+  EXPECT_TRUE(7u >= big_integer(7));
+  EXPECT_TRUE(big_integer(0) > INT64_MIN);
+
+  EXPECT_EQ(big_integer(3), big_integer(-4) + 7);
+  EXPECT_EQ(big_integer(-11), big_integer(-4) - 7ull);
+  EXPECT_EQ(big_integer(-3), 7 - big_integer(10));
+  EXPECT_EQ(big_integer(-3), -7 + big_integer(4));
+  EXPECT_EQ(big_integer(0), big_integer(-4) + 4);
+  EXPECT_EQ(-a, big_integer(-1) - UINT64_MAX);
+  EXPECT_EQ(big_integer(-1), INT64_MAX - (a >> 1));
+  EXPECT_EQ(big_integer(1), a - UINT64_MAX);
+  EXPECT_EQ(a + (a >> 1) - 1, INT64_MIN * big_integer(-2) + INT64_MAX);
+  EXPECT_EQ(big_integer(0), big_integer(0) * -3);
+  EXPECT_EQ(big_integer(-6), -3 * big_integer(2));
+
+  big_integer b = a;
+  b *= UINT64_MAX;
+  EXPECT_EQ((a << 64) - a, b);
+  b += b;
+  b -= INT64_MIN;
+  EXPECT_EQ((a << 65) - (a << 1) + (a >> 1), b);
+}
+
+TEST(correctness_random, builtin_operands) {
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer a = rand_big(itn % 5);
+    if (rand() % 2) {
+      a = -a;
+    }
+    int64_t x = static_cast<int64_t>(static_cast<uint64_t>(rand()) << 33 ^ static_cast<uint64_t>(rand()) << (rand() % 33));
+    if (rand() % 2) {
+      x = -x;
+    }
+    big_integer y(std::to_string(x));
+    EXPECT_EQ(a + y, a + x);
+    EXPECT_EQ(a - y, a - x);
+    EXPECT_EQ(y - a, x - a);
+    EXPECT_EQ(a * y, a * x);
+    EXPECT_EQ(a < y, a < x);
+    EXPECT_EQ(a == y, a == x);
+    EXPECT_EQ(y >= a, x >= a);
+  }
+}
+
+TEST(correctness, small_values_overflow) {
+  big_integer max(INT64_MAX);
+  big_integer min(INT64_MIN);
+  EXPECT_EQ(big_integer("9223372036854775808"), max + big_integer(1));
+  EXPECT_EQ(big_integer("-9223372036854775809"), min - big_integer(1));
+  EXPECT_EQ(big_integer("-18446744073709551615"), -max - max - big_integer(1));
+  EXPECT_EQ(big_integer("85070591730234615847396907784232501249"), max * max);
+  EXPECT_EQ(big_integer("9223372036854775808"), min / big_integer(-1));
+  EXPECT_EQ(big_integer(0), min % big_integer(-1));
+  EXPECT_EQ(big_integer(-2), big_integer(-7) / big_integer(3));
+  EXPECT_EQ(big_integer(-1), big_integer(-7) % big_integer(3));
+  EXPECT_EQ(big_integer(1), big_integer(7) % big_integer(-3));
+  EXPECT_TRUE(min < -max);
+  EXPECT_TRUE(max + big_integer(1) > max);
+
+  big_integer a = max;
+  a += a;
+  EXPECT_EQ(big_integer("18446744073709551614"), a);
+  a -= a;
+  EXPECT_EQ(big_integer(0), a);
+}
+
+TEST(correctness, gcd) {
+  EXPECT_EQ(big_integer(6), gcd(big_integer(48), big_integer(-18)));
+  EXPECT_EQ(big_integer(7), gcd(big_integer(0), big_integer(7)));
+  EXPECT_EQ(big_integer(0), gcd(big_integer(0), big_integer(0)));
+  big_integer p("170141183460469231731687303715884105727");
+  EXPECT_EQ(p, gcd(p * 12345, p * 67890 + p));
+}
+
+TEST(correctness, rational_simple) {
+  big_rational a(1, 2);
+  big_rational b(1, 3);
+  EXPECT_EQ("5/6", to_string(a + b));
+  EXPECT_EQ("1/6", to_string(a - b));
+  EXPECT_EQ("1/6", to_string(a * b));
+  EXPECT_EQ("3/2", to_string(a / b));
+  EXPECT_EQ("-1/2", to_string(big_rational(2, -4)));
+  EXPECT_EQ("1", to_string(a + a));
+  EXPECT_EQ("0", to_string(a - a));
+  EXPECT_EQ(big_rational(3), a * 6);
+  EXPECT_TRUE(b < a);
+  EXPECT_TRUE(-a < b);
+  EXPECT_TRUE(big_rational(2, 4) == a);
+  EXPECT_TRUE(big_rational(2, 4) != b);
+
+  std::stringstream s;
+  s << big_rational(-6, 4);
+  EXPECT_EQ("-3/2", s.str());
+
+  EXPECT_THROW(big_rational(1, 0), std::domain_error);
+  EXPECT_THROW(a / big_rational(), std::domain_error);
+}
+
+TEST(correctness, rational_lazy) {
+  big_rational a(6, 4);
+  EXPECT_FALSE(a.is_reduced());
+  EXPECT_EQ(big_integer(3), a.numerator());
+  EXPECT_EQ(big_integer(2), a.denominator());
+  EXPECT_TRUE(a.is_reduced());
+
+  big_rational::set_reduce_threshold(0);
+  EXPECT_TRUE(big_rational(6, 4).is_reduced());
+  EXPECT_TRUE((a * big_rational(2, 3)).is_reduced());
+  big_rational::set_reduce_threshold(big_rational::REDUCE_THRESHOLD);
+}
+
+TEST(correctness_random, rational) {
+  // sum and product of 1/k * (k+1)/(k+2) terms, lazy and eager
+  for (size_t threshold : {static_cast<size_t>(0), static_cast<size_t>(4), big_rational::REDUCE_THRESHOLD}) {
+    big_rational::set_reduce_threshold(threshold);
+    big_rational sum;
+    big_rational prod = 1;
+    for (int k = 1; k != 200; ++k) {
+      sum += big_rational(1, k * (k + 1));
+      prod *= big_rational(k, k + 1);
+    }
+    EXPECT_EQ("199/200", to_string(sum));
+    EXPECT_EQ("1/200", to_string(prod));
+  }
+  big_rational::set_reduce_threshold(big_rational::REDUCE_THRESHOLD);
+
+  for (size_t i = 0; i != number_of_iterations; ++i) {
+    big_integer a = rand_big(4), b = rand_big(4) + 1, c = rand_big(4), d = rand_big(4) + 1;
+    big_rational x(a, b), y(c, d);
+    EXPECT_EQ(x, x + y - y);
+    if (c != 0) {
+      EXPECT_EQ(x, x * y / y);
+    }
+    big_integer g = gcd(a, b);
+    EXPECT_EQ(a / g, x.numerator());
+    EXPECT_EQ(b / g, x.denominator());
+  }
+}
@@ -0,0 +1,218 @@
+#include "big_rational.h"
+
+#include <ostream>
+#include <stdexcept>
+
+// Helpful functions
+
+namespace {
+    size_t reduce_threshold = big_rational::REDUCE_THRESHOLD;
+}
+
+// Private methods
+
+size_t big_rational::size() const {
+    return num_.val_.size() + den_.val_.size();
+}
+
+bool big_rational::reduce_due(size_t size) const {
+    return size > reduce_threshold;
+}
+
+void big_rational::reduce_if_due() {
+    if (!reduced_ && reduce_due(size())) {
+        reduce();
+    }
+}
+
+int big_rational::cmp(big_rational const& rhs) const {
+    reduce();
+    rhs.reduce();
+    if (den_ == rhs.den_) {
+        return num_.cmp(rhs.num_);
+    }
+    return (num_ * rhs.den_).cmp(rhs.num_ * den_);
+}
+
+void big_rational::add(big_rational const& rhs, int sign) {
+    big_integer c = sign < 0 ? -rhs.num_ : rhs.num_;
+    if (den_ == rhs.den_) {
+        num_ += c;
+        reduced_ = den_ == 1;
+        reduce_if_due();
+    } else if (reduced_ && rhs.reduced_ && reduce_due(size() + rhs.size())) {
+        // a/b + c/d = (a * d/g + c * b/g) / (b/g * d) with g = gcd(b, d),
+        // the sum can only share factors of g with the denominator
+        big_integer g = gcd(den_, rhs.den_);
+        if (g == 1) {
+            num_ = num_ * rhs.den_ + c * den_;
+            den_ *= rhs.den_;
+        } else {
+            big_integer b = den_ / g;
+            big_integer t = num_ * (rhs.den_ / g) + c * b;
+            big_integer g2 = gcd(t, g);
+            num_ = t / g2;
+            den_ = b * (rhs.den_ / g2);
+        }
+        if (num_ == 0) {
+            den_ = 1;
+        }
+    } else {
+        num_ = num_ * rhs.den_ + c * den_;
+        den_ *= rhs.den_;
+        reduced_ = false;
+        reduce_if_due();
+    }
+}
+
+// Public methods
+
+big_rational::big_rational() : num_(0), den_(1), reduced_(true)
+{}
+
+big_rational::big_rational(big_integer const& num) : num_(num), den_(1), reduced_(true)
+{}
+
+big_rational::big_rational(int num) : big_rational(big_integer(num))
+{}
+
+big_rational::big_rational(big_integer const& num, big_integer const& den) : num_(num), den_(den) {
+    if (den_ == 0) {
+        throw std::domain_error("Zero denominator");
+    }
+    if (den_ < 0) {
+        num_ = -num_;
+        den_ = -den_;
+    }
+    reduced_ = den_ == 1;
+    reduce_if_due();
+}
+
+void big_rational::set_reduce_threshold(size_t threshold) {
+    reduce_threshold = threshold;
+}
+
+big_integer const& big_rational::numerator() const {
+    reduce();
+    return num_;
+}
+
+big_integer const& big_rational::denominator() const {
+    reduce();
+    return den_;
+}
+
+void big_rational::reduce() const {
+    if (reduced_) {
+        return;
+    }
+    big_integer g = gcd(num_, den_);
+    if (g != 1) {
+        num_ /= g;
+        den_ /= g;
+    }
+    reduced_ = true;
+}
+
+bool big_rational::is_reduced() const {
+    return reduced_;
+}
+
+big_rational& big_rational::operator+=(big_rational const& rhs) {
+    add(rhs, 1);
+    return *this;
+}
+
+big_rational& big_rational::operator-=(big_rational const& rhs) {
+    add(rhs, -1);
+    return *this;
+}
+
+big_rational& big_rational::operator*=(big_rational const& rhs) {
+    if (reduced_ && rhs.reduced_ && reduce_due(size() + rhs.size())) {
+        // (a/b) * (c/d) = (a/g1 * c/g2) / (b/g2 * d/g1) with g1 = gcd(a, d), g2 = gcd(c, b)
+        big_integer g1 = gcd(num_, rhs.den_);
+        big_integer g2 = gcd(rhs.num_, den_);
+        num_ = (num_ / g1) * (rhs.num_ / g2);
+        den_ = (den_ / g2) * (rhs.den_ / g1);
+    } else {
+        num_ *= rhs.num_;
+        den_ *= rhs.den_;
+        reduced_ = false;
+        reduce_if_due();
+    }
+    return *this;
+}
+
+big_rational& big_rational::operator/=(big_rational const& rhs) {
+    if (rhs.num_ == 0) {
+        throw std::domain_error("Division by zero");
+    }
+    big_rational inverse;
+    inverse.num_ = rhs.num_ < 0 ? -rhs.den_ : rhs.den_;
+    inverse.den_ = rhs.num_ < 0 ? -rhs.num_ : rhs.num_;
+    inverse.reduced_ = rhs.reduced_;
+    return *this *= inverse;
+}
+
+big_rational big_rational::operator+() const {
+    return *this;
+}
+
+big_rational big_rational::operator-() const {
+    big_rational res = *this;
+    res.num_ = -res.num_;
+    return res;
+}
+
+bool operator==(big_rational const& a, big_rational const& b) {
+    return a.cmp(b) == 0;
+}
+
+bool operator!=(big_rational const& a, big_rational const& b) {
+    return a.cmp(b) != 0;
+}
+
+bool operator<(big_rational const& a, big_rational const& b) {
+    return a.cmp(b) < 0;
+}
+
+bool operator>(big_rational const& a, big_rational const& b) {
+    return a.cmp(b) > 0;
+}
+
+bool operator<=(big_rational const& a, big_rational const& b) {
+    return a.cmp(b) <= 0;
+}
+
+bool operator>=(big_rational const& a, big_rational const& b) {
+    return a.cmp(b) >= 0;
+}
+
+std::string to_string(big_rational const& a) {
+    a.reduce();
+    if (a.den_ == 1) {
+        return to_string(a.num_);
+    }
+    return to_string(a.num_) + "/" + to_string(a.den_);
+}
+
+big_rational operator+(big_rational a, big_rational const& b) {
+    return a += b;
+}
+
+big_rational operator-(big_rational a, big_rational const& b) {
+    return a -= b;
+}
+
+big_rational operator*(big_rational a, big_rational const& b) {
+    return a *= b;
+}
+
+big_rational operator/(big_rational a, big_rational const& b) {
+    return a /= b;
+}
+
+std::ostream& operator<<(std::ostream& s, big_rational const& a) {
+    return s << to_string(a);
+}
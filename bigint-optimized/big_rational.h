@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include "big_integer.h"
+
+// Exact fraction num / den with den > 0.
+// Reduction by the gcd is lazy : it happens once the numerator and the denominator
+// together pass the reduce threshold, on comparison, on output and on numerator() /
+// denominator(). When both operands are reduced, + - * / cancel common factors of
+// the smaller cross terms first, so the intermediates stay small and the result is
+// reduced as well.
+// Const methods may reduce the stored value, so a big_rational shared between
+// threads must not be compared or printed concurrently.
+struct big_rational {
+    // Limb count of num + den past which results are reduced
+    constexpr static size_t REDUCE_THRESHOLD = 16;
+
+    big_rational();
+    big_rational(big_integer const& num);
+    big_rational(int num);
+    // Throws std::domain_error if den == 0
+    big_rational(big_integer const& num, big_integer const& den);
+
+    // threshold = 0 reduces after every operation.
+    // Must not be called while other threads use big_rationals.
+    static void set_reduce_threshold(size_t threshold);
+
+    big_integer const& numerator() const;
+    big_integer const& denominator() const;
+
+    void reduce() const;
+    bool is_reduced() const;
+
+    big_rational& operator+=(big_rational const& rhs);
+    big_rational& operator-=(big_rational const& rhs);
+    big_rational& operator*=(big_rational const& rhs);
+    // Throws std::domain_error on division by zero
+    big_rational& operator/=(big_rational const& rhs);
+
+    big_rational operator+() const;
+    big_rational operator-() const;
+
+    friend bool operator==(big_rational const& a, big_rational const& b);
+    friend bool operator!=(big_rational const& a, big_rational const& b);
+    friend bool operator<(big_rational const& a, big_rational const& b);
+    friend bool operator>(big_rational const& a, big_rational const& b);
+    friend bool operator<=(big_rational const& a, big_rational const& b);
+    friend bool operator>=(big_rational const& a, big_rational const& b);
+
+    // "num/den", or "num" for integers
+    friend std::string to_string(big_rational const& a);
+
+ private:
+    mutable big_integer num_;
+    mutable big_integer den_;
+    mutable bool reduced_;
+
+    size_t size() const;
+    bool reduce_due(size_t size) const;
+    void reduce_if_due();
+    int cmp(big_rational const& rhs) const;
+    // (*this)' = *this + sign * rhs
+    void add(big_rational const& rhs, int sign);
+};
+
+big_rational operator+(big_rational a, big_rational const& b);
+big_rational operator-(big_rational a, big_rational const& b);
+big_rational operator*(big_rational a, big_rational const& b);
+big_rational operator/(big_rational a, big_rational const& b);
+
+std::ostream& operator<<(std::ostream& s, big_rational const& a);
@@ -0,0 +1,129 @@
+#include "combinatorics.h"
+
+#include <vector>
+#include <future>
+#include <functional>
+#include <algorithm>
+
+// Helpful functions
+
+namespace {
+    // Ranges shorter than this are multiplied sequentially
+    constexpr size_t LEAF_SIZE = 16;
+    // Subtrees shorter than this are never handed to another thread
+    constexpr size_t PARALLEL_SIZE = 1024;
+
+    big_integer from_uint32(uint32_t val) {
+        big_integer res = static_cast<int>(val >> 16);
+        res <<= 16;
+        return res += static_cast<int>(val & 0xFFFF);
+    }
+
+    // f[lo] * f[lo + 1] * ... * f[hi - 1]
+    big_integer product_range(std::vector<uint32_t> const& f, size_t lo, size_t hi, unsigned threads) {
+        if (hi - lo <= LEAF_SIZE) {
+            big_integer res = 1;
+            // Pack neighbouring factors into a single int while it is possible
+            uint64_t acc = 1;
+            for (size_t i = lo; i != hi; ++i) {
+                if (acc != 1 && acc * f[i] > INT32_MAX) {
+                    res *= from_uint32(static_cast<uint32_t>(acc));
+                    acc = 1;
+                }
+                acc *= f[i];
+            }
+            return res *= from_uint32(static_cast<uint32_t>(acc));
+        }
+        size_t mid = lo + (hi - lo) / 2;
+        if (threads > 1 && hi - lo >= PARALLEL_SIZE) {
+            std::future<big_integer> left = std::async(std::launch::async, product_range,
+                                                       std::cref(f), lo, mid, threads / 2);
+            big_integer right = product_range(f, mid, hi, threads - threads / 2);
+            return left.get() * right;
+        }
+        return product_range(f, lo, mid, threads) * product_range(f, mid, hi, threads);
+    }
+
+    big_integer product(std::vector<uint32_t> const& f, unsigned threads) {
+        return product_range(f, 0, f.size(), threads);
+    }
+
+    // Sieve of Eratosthenes : all primes <= n
+    std::vector<uint32_t> primes_up_to(uint32_t n) {
+        std::vector<uint32_t> primes;
+        if (n < 2) {
+            return primes;
+        }
+        std::vector<bool> composite(static_cast<size_t>(n) + 1);
+        for (uint64_t i = 2; i <= n; ++i) {
+            if (!composite[i]) {
+                primes.push_back(static_cast<uint32_t>(i));
+                for (uint64_t j = i * i; j <= n; j += i) {
+                    composite[j] = true;
+                }
+            }
+        }
+        return primes;
+    }
+
+    // Exponent of prime p in n! (Legendre's formula)
+    uint64_t factorial_exponent(uint32_t n, uint32_t p) {
+        uint64_t e = 0;
+        for (uint64_t q = n; q != 0; ) {
+            q /= p;
+            e += q;
+        }
+        return e;
+    }
+}
+
+big_integer factorial(uint32_t n, unsigned threads) {
+    // n! = 2^(n - popcount(n)) * odd(n), where every odd m <= n occurs in odd(n)
+    // exactly as many times as there are k >= 0 with m * 2^k <= n. The odd numbers
+    // in (n / 2^(k + 1), n / 2^k] form the k-th layer and enter odd(n) k + 1 times.
+    big_integer res = 1;
+    big_integer layers = 1;
+    int levels = n == 0 ? 0 : 32 - __builtin_clz(n);
+    std::vector<uint32_t> odd;
+    for (int k = levels - 1; k >= 0; --k) {
+        uint32_t lo = static_cast<uint32_t>((static_cast<uint64_t>(n) >> (k + 1)) + 1) | 1;
+        uint32_t hi = n >> k;
+        odd.clear();
+        for (uint64_t m = lo; m <= hi; m += 2) {
+            odd.push_back(static_cast<uint32_t>(m));
+        }
+        if (!odd.empty()) {
+            layers *= product(odd, threads);
+        }
+        res *= layers;
+    }
+    return res <<= static_cast<int>(n - __builtin_popcount(n));
+}
+
+big_integer binomial(uint32_t n, uint32_t k, unsigned threads) {
+    if (k > n) {
+        return 0;
+    }
+    // Every prime enters with exponent e(n) - e(k) - e(n - k), where e(m) is
+    // its exponent in m!. Two is applied as a shift, the rest as a product tree.
+    std::vector<uint32_t> factors;
+    int shift = 0;
+    for (uint32_t p : primes_up_to(n)) {
+        uint64_t e = factorial_exponent(n, p) - factorial_exponent(k, p) - factorial_exponent(n - k, p);
+        if (p == 2) {
+            shift = static_cast<int>(e);
+            continue;
+        }
+        factors.insert(factors.end(), e, p);
+    }
+    return product(factors, threads) <<= shift;
+}
+
+big_integer primorial(uint32_t n, unsigned threads) {
+    std::vector<uint32_t> primes = primes_up_to(n);
+    if (primes.empty()) {
+        return 1;
+    }
+    primes.erase(primes.begin());
+    return product(primes, threads) <<= 1;
+}
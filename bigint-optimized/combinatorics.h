@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include "big_integer.h"
+
+// All functions multiply their factors with a balanced product tree, so the
+// operands of each multiplication have roughly equal length. Powers of two are
+// counted separately and applied with a single shift.
+// threads > 1 lets large subtrees be computed concurrently.
+
+// n!
+big_integer factorial(uint32_t n, unsigned threads = 1);
+
+// n! / (k! * (n - k)!), 0 if k > n
+big_integer binomial(uint32_t n, uint32_t k, unsigned threads = 1);
+
+// Product of all primes <= n
+big_integer primorial(uint32_t n, unsigned threads = 1);
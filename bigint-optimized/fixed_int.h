@@ -0,0 +1,508 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <ostream>
+#include <stdexcept>
+#include <algorithm>
+#include "big_integer.h"
+
+// Calls f(I), f(I + 1), ..., f(N - 1); after inlining the loop is fully unrolled
+template <size_t I, size_t N>
+struct fixed_int_unroll {
+    template <typename F>
+    static void run(F const& f) {
+        f(I);
+        fixed_int_unroll<I + 1, N>::run(f);
+    }
+};
+
+template <size_t N>
+struct fixed_int_unroll<N, N> {
+    template <typename F>
+    static void run(F const&)
+    {}
+};
+
+// Integer of exactly Bits bits kept on the stack : no heap, no reference
+// counter, no normalization. Arithmetic wraps modulo 2^Bits, signed values
+// are kept in two's complement. The operators mirror big_integer.
+template <size_t Bits, bool Signed = true>
+struct fixed_int {
+    static_assert(Bits % 32 == 0 && Bits != 0, "Bits must be a positive multiple of 32");
+
+    using number_t = number_storage::number_t;
+    using big_number_t = number_storage::big_number_t;
+
+    constexpr static size_t SIZE = Bits / 32;
+
+    fixed_int();
+    fixed_int(int a);
+    explicit fixed_int(std::string const& str);
+    // Takes a modulo 2^Bits
+    explicit fixed_int(big_integer const& a);
+
+    explicit operator big_integer() const;
+
+    fixed_int& operator+=(fixed_int const& rhs);
+    fixed_int& operator-=(fixed_int const& rhs);
+    fixed_int& operator*=(fixed_int const& rhs);
+    // Throw std::domain_error on division by zero
+    fixed_int& operator/=(fixed_int const& rhs);
+    fixed_int& operator%=(fixed_int const& rhs);
+
+    fixed_int& operator&=(fixed_int const& rhs);
+    fixed_int& operator|=(fixed_int const& rhs);
+    fixed_int& operator^=(fixed_int const& rhs);
+
+    fixed_int& operator<<=(int rhs);
+    // Arithmetic shift for signed values
+    fixed_int& operator>>=(int rhs);
+
+    fixed_int operator+() const;
+    fixed_int operator-() const;
+    fixed_int operator~() const;
+
+    fixed_int& operator++();
+    fixed_int operator++(int);
+
+    fixed_int& operator--();
+    fixed_int operator--(int);
+
+    friend fixed_int operator+(fixed_int a, fixed_int const& b) { return a += b; }
+    friend fixed_int operator-(fixed_int a, fixed_int const& b) { return a -= b; }
+    friend fixed_int operator*(fixed_int a, fixed_int const& b) { return a *= b; }
+    friend fixed_int operator/(fixed_int a, fixed_int const& b) { return a /= b; }
+    friend fixed_int operator%(fixed_int a, fixed_int const& b) { return a %= b; }
+
+    friend fixed_int operator&(fixed_int a, fixed_int const& b) { return a &= b; }
+    friend fixed_int operator|(fixed_int a, fixed_int const& b) { return a |= b; }
+    friend fixed_int operator^(fixed_int a, fixed_int const& b) { return a ^= b; }
+
+    friend fixed_int operator<<(fixed_int a, int b) { return a <<= b; }
+    friend fixed_int operator>>(fixed_int a, int b) { return a >>= b; }
+
+    friend bool operator==(fixed_int const& a, fixed_int const& b) { return a.cmp(b) == 0; }
+    friend bool operator!=(fixed_int const& a, fixed_int const& b) { return a.cmp(b) != 0; }
+    friend bool operator<(fixed_int const& a, fixed_int const& b) { return a.cmp(b) < 0; }
+    friend bool operator>(fixed_int const& a, fixed_int const& b) { return a.cmp(b) > 0; }
+    friend bool operator<=(fixed_int const& a, fixed_int const& b) { return a.cmp(b) <= 0; }
+    friend bool operator>=(fixed_int const& a, fixed_int const& b) { return a.cmp(b) >= 0; }
+
+    friend std::string to_string(fixed_int const& a) { return a.str(); }
+    friend std::ostream& operator<<(std::ostream& s, fixed_int const& a) { return s << a.str(); }
+
+ private:
+    using unroll = fixed_int_unroll<0, SIZE>;
+    using limbs_t = number_t[SIZE];
+
+    limbs_t val_;
+
+    bool is_negative() const;
+    int cmp(fixed_int const& rhs) const;
+    std::string str() const;
+
+    // Methods on unsigned magnitudes :
+
+    // lng' = lng * shrt + add, returns the carry
+    static number_t mul_short(limbs_t& lng, number_t shrt, number_t add);
+    // lng' = lng / shrt, returns the remainder
+    static number_t div_short(limbs_t& lng, number_t shrt);
+    // Knuth's algorithm D
+    static void div_mod(limbs_t const& u, limbs_t const& v, limbs_t& q, limbs_t& r);
+};
+
+template <size_t Bits>
+using fixed_uint = fixed_int<Bits, false>;
+
+template <size_t Bits, bool Signed>
+constexpr size_t fixed_int<Bits, Signed>::SIZE;
+
+// Private methods
+
+template <size_t Bits, bool Signed>
+bool fixed_int<Bits, Signed>::is_negative() const {
+    return Signed && (val_[SIZE - 1] >> 31) != 0;
+}
+
+template <size_t Bits, bool Signed>
+int fixed_int<Bits, Signed>::cmp(fixed_int const& rhs) const {
+    if (is_negative() != rhs.is_negative()) {
+        return is_negative() ? -1 : 1;
+    }
+    // With equal signs two's complement representations compare as unsigned numbers
+    for (size_t i = SIZE; i != 0; ) {
+        --i;
+        if (val_[i] != rhs.val_[i]) {
+            return val_[i] < rhs.val_[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+template <size_t Bits, bool Signed>
+std::string fixed_int<Bits, Signed>::str() const {
+    constexpr number_t CHUNK = 1000000000;
+    limbs_t mag;
+    fixed_int abs = is_negative() ? -*this : *this;
+    std::copy(abs.val_, abs.val_ + SIZE, mag);
+    std::string res;
+    bool zero = false;
+    while (!zero) {
+        number_t rem = div_short(mag, CHUNK);
+        zero = std::all_of(mag, mag + SIZE, [](number_t x) { return x == 0; });
+        for (int i = 0; i != 9 && (!zero || rem != 0); ++i) {
+            res.push_back(static_cast<char>('0' + rem % 10));
+            rem /= 10;
+        }
+    }
+    if (res.empty()) {
+        res = "0";
+    }
+    if (is_negative()) {
+        res.push_back('-');
+    }
+    std::reverse(res.begin(), res.end());
+    return res;
+}
+
+template <size_t Bits, bool Signed>
+typename fixed_int<Bits, Signed>::number_t fixed_int<Bits, Signed>::mul_short(limbs_t& lng, number_t shrt,
+                                                                              number_t add) {
+    big_number_t carry = add;
+    unroll::run([&](size_t i) {
+        carry += static_cast<big_number_t>(lng[i]) * shrt;
+        lng[i] = static_cast<number_t>(carry);
+        carry >>= 32;
+    });
+    return static_cast<number_t>(carry);
+}
+
+template <size_t Bits, bool Signed>
+typename fixed_int<Bits, Signed>::number_t fixed_int<Bits, Signed>::div_short(limbs_t& lng, number_t shrt) {
+    big_number_t rem = 0;
+    unroll::run([&](size_t i) {
+        size_t j = SIZE - 1 - i;
+        big_number_t cur = (rem << 32) | lng[j];
+        lng[j] = static_cast<number_t>(cur / shrt);
+        rem = cur % shrt;
+    });
+    return static_cast<number_t>(rem);
+}
+
+template <size_t Bits, bool Signed>
+void fixed_int<Bits, Signed>::div_mod(limbs_t const& u, limbs_t const& v, limbs_t& q, limbs_t& r) {
+    size_t m = SIZE;
+    while (m != 0 && u[m - 1] == 0) {
+        --m;
+    }
+    size_t n = SIZE;
+    while (n != 0 && v[n - 1] == 0) {
+        --n;
+    }
+    if (n == 0) {
+        throw std::domain_error("division by zero");
+    }
+    std::fill(q, q + SIZE, 0);
+    std::fill(r, r + SIZE, 0);
+    if (m < n) {
+        std::copy(u, u + SIZE, r);
+        return;
+    }
+    if (n == 1) {
+        std::copy(u, u + SIZE, q);
+        r[0] = div_short(q, v[0]);
+        return;
+    }
+
+    // Normalize, so that the top limb of the divisor has its high bit set
+    int s = __builtin_clz(v[n - 1]);
+    number_t vn[SIZE];
+    number_t un[SIZE + 1];
+    for (size_t i = n - 1; i != 0; --i) {
+        vn[i] = (v[i] << s) | (s == 0 ? 0 : v[i - 1] >> (32 - s));
+    }
+    vn[0] = v[0] << s;
+    un[m] = s == 0 ? 0 : u[m - 1] >> (32 - s);
+    for (size_t i = m - 1; i != 0; --i) {
+        un[i] = (u[i] << s) | (s == 0 ? 0 : u[i - 1] >> (32 - s));
+    }
+    un[0] = u[0] << s;
+
+    constexpr big_number_t BASE = static_cast<big_number_t>(UINT32_MAX) + 1;
+    for (size_t j = m - n + 1; j != 0; ) {
+        --j;
+        big_number_t num = (static_cast<big_number_t>(un[j + n]) << 32) | un[j + n - 1];
+        big_number_t qhat = num / vn[n - 1];
+        big_number_t rhat = num % vn[n - 1];
+        while (qhat >= BASE || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+            --qhat;
+            rhat += vn[n - 1];
+            if (rhat >= BASE) {
+                break;
+            }
+        }
+
+        // un[j .. j + n] -= qhat * vn
+        int64_t borrow = 0;
+        int64_t t;
+        for (size_t i = 0; i != n; ++i) {
+            big_number_t p = qhat * vn[i];
+            t = un[i + j] - borrow - static_cast<int64_t>(p & 0xFFFFFFFF);
+            un[i + j] = static_cast<number_t>(t);
+            borrow = static_cast<int64_t>(p >> 32) - (t >> 32);
+        }
+        t = un[j + n] - borrow;
+        un[j + n] = static_cast<number_t>(t);
+
+        q[j] = static_cast<number_t>(qhat);
+        if (t < 0) {
+            // qhat was one too large, add vn back
+            --q[j];
+            big_number_t carry = 0;
+            for (size_t i = 0; i != n; ++i) {
+                carry += static_cast<big_number_t>(un[i + j]) + vn[i];
+                un[i + j] = static_cast<number_t>(carry);
+                carry >>= 32;
+            }
+            un[j + n] += static_cast<number_t>(carry);
+        }
+    }
+
+    for (size_t i = 0; i + 1 != n; ++i) {
+        r[i] = (un[i] >> s) | (s == 0 ? 0 : un[i + 1] << (32 - s));
+    }
+    r[n - 1] = un[n - 1] >> s;
+}
+
+// Public methods
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>::fixed_int() : fixed_int(0)
+{}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>::fixed_int(int a) {
+    number_t ext = a < 0 ? UINT32_MAX : 0;
+    unroll::run([&](size_t i) {
+        val_[i] = ext;
+    });
+    val_[0] = static_cast<number_t>(a);
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>::fixed_int(std::string const& str) : fixed_int() {
+    bool negative = !str.empty() && str.front() == '-';
+    if (str.size() == static_cast<size_t>(negative)) {
+        throw std::runtime_error("Empty string");
+    }
+    for (size_t i = negative ? 1 : 0; i != str.size(); ++i) {
+        if (str[i] < '0' || str[i] > '9') {
+            std::string message = "Invalid character : ";
+            message += str[i];
+            throw std::runtime_error(message);
+        }
+        mul_short(val_, 10, static_cast<number_t>(str[i] - '0'));
+    }
+    if (negative) {
+        *this = -*this;
+    }
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>::fixed_int(big_integer const& a) : fixed_int() {
+    size_t size = std::min(SIZE, a.val_.size());
+    std::copy(a.val_.begin(), a.val_.begin() + size, val_);
+    if (a.sign_) {
+        *this = -*this;
+    }
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>::operator big_integer() const {
+    fixed_int abs = is_negative() ? -*this : *this;
+    big_integer res(0, SIZE);
+    std::copy(abs.val_, abs.val_ + SIZE, res.val_.begin());
+    res.clear_back();
+    res.sign_ = is_negative();
+    return res;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>& fixed_int<Bits, Signed>::operator+=(fixed_int const& rhs) {
+    big_number_t carry = 0;
+    unroll::run([&](size_t i) {
+        carry += static_cast<big_number_t>(val_[i]) + rhs.val_[i];
+        val_[i] = static_cast<number_t>(carry);
+        carry >>= 32;
+    });
+    return *this;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>& fixed_int<Bits, Signed>::operator-=(fixed_int const& rhs) {
+    number_t borrow = 0;
+    unroll::run([&](size_t i) {
+        big_number_t cur = static_cast<big_number_t>(val_[i]) - rhs.val_[i] - borrow;
+        val_[i] = static_cast<number_t>(cur);
+        borrow = static_cast<number_t>(cur >> 63);
+    });
+    return *this;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>& fixed_int<Bits, Signed>::operator*=(fixed_int const& rhs) {
+    // Only the products that land below 2^Bits are computed, zero high limbs of rhs are skipped
+    size_t n = SIZE;
+    while (n > 1 && rhs.val_[n - 1] == 0) {
+        --n;
+    }
+    limbs_t res = {};
+    unroll::run([&](size_t i) {
+        if (val_[i] == 0) {
+            return;
+        }
+        big_number_t carry = 0;
+        size_t end = std::min(SIZE - i, n + 1);
+        for (size_t j = 0; j != end; ++j) {
+            carry += res[i + j] + static_cast<big_number_t>(val_[i]) * (j < n ? rhs.val_[j] : 0);
+            res[i + j] = static_cast<number_t>(carry);
+            carry >>= 32;
+        }
+    });
+    std::copy(res, res + SIZE, val_);
+    return *this;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>& fixed_int<Bits, Signed>::operator/=(fixed_int const& rhs) {
+    bool negative = is_negative() != rhs.is_negative();
+    fixed_int u = is_negative() ? -*this : *this;
+    fixed_int v = rhs.is_negative() ? -rhs : rhs;
+    limbs_t r;
+    div_mod(u.val_, v.val_, val_, r);
+    if (negative) {
+        *this = -*this;
+    }
+    return *this;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>& fixed_int<Bits, Signed>::operator%=(fixed_int const& rhs) {
+    bool negative = is_negative();
+    fixed_int u = is_negative() ? -*this : *this;
+    fixed_int v = rhs.is_negative() ? -rhs : rhs;
+    limbs_t q;
+    div_mod(u.val_, v.val_, q, val_);
+    if (negative) {
+        *this = -*this;
+    }
+    return *this;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>& fixed_int<Bits, Signed>::operator&=(fixed_int const& rhs) {
+    unroll::run([&](size_t i) {
+        val_[i] &= rhs.val_[i];
+    });
+    return *this;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>& fixed_int<Bits, Signed>::operator|=(fixed_int const& rhs) {
+    unroll::run([&](size_t i) {
+        val_[i] |= rhs.val_[i];
+    });
+    return *this;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>& fixed_int<Bits, Signed>::operator^=(fixed_int const& rhs) {
+    unroll::run([&](size_t i) {
+        val_[i] ^= rhs.val_[i];
+    });
+    return *this;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>& fixed_int<Bits, Signed>::operator<<=(int rhs) {
+    size_t limbs = static_cast<size_t>(rhs) / 32;
+    int shift = rhs % 32;
+    limbs_t res = {};
+    for (size_t i = limbs; i < SIZE; ++i) {
+        res[i] = val_[i - limbs] << shift;
+        if (shift != 0 && i != limbs) {
+            res[i] |= val_[i - limbs - 1] >> (32 - shift);
+        }
+    }
+    std::copy(res, res + SIZE, val_);
+    return *this;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>& fixed_int<Bits, Signed>::operator>>=(int rhs) {
+    size_t limbs = static_cast<size_t>(rhs) / 32;
+    int shift = rhs % 32;
+    number_t ext = is_negative() ? UINT32_MAX : 0;
+    limbs_t res;
+    for (size_t i = 0; i != SIZE; ++i) {
+        number_t low = i + limbs < SIZE ? val_[i + limbs] : ext;
+        number_t high = i + limbs + 1 < SIZE ? val_[i + limbs + 1] : ext;
+        res[i] = shift == 0 ? low : (low >> shift) | (high << (32 - shift));
+    }
+    std::copy(res, res + SIZE, val_);
+    return *this;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed> fixed_int<Bits, Signed>::operator+() const {
+    return *this;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed> fixed_int<Bits, Signed>::operator-() const {
+    fixed_int r = ~*this;
+    return ++r;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed> fixed_int<Bits, Signed>::operator~() const {
+    fixed_int r;
+    unroll::run([&](size_t i) {
+        r.val_[i] = ~val_[i];
+    });
+    return r;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>& fixed_int<Bits, Signed>::operator++() {
+    size_t i = 0;
+    while (i != SIZE && ++val_[i] == 0) {
+        ++i;
+    }
+    return *this;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed> fixed_int<Bits, Signed>::operator++(int) {
+    fixed_int r = *this;
+    ++*this;
+    return r;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed>& fixed_int<Bits, Signed>::operator--() {
+    size_t i = 0;
+    while (i != SIZE && val_[i]-- == 0) {
+        ++i;
+    }
+    return *this;
+}
+
+template <size_t Bits, bool Signed>
+fixed_int<Bits, Signed> fixed_int<Bits, Signed>::operator--(int) {
+    fixed_int r = *this;
+    --*this;
+    return r;
+}
@@ -0,0 +1,111 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <gmp.h>
+
+#include "big_integer.h"
+#include "fixed_int.h"
+
+// Compares fixed_int<Bits> with big_integer and GMP's mpz_t on the same operands :
+// every operation is applied to OPERANDS pairs, the time per operation is printed.
+
+namespace {
+    size_t const OPERANDS = 1000;
+    size_t const REPEATS = 200;
+
+    // Makes the compiler assume that the value is read and written
+    template <typename T>
+    void escape(T& value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    template <typename F>
+    double measure(F const& f) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r != REPEATS; ++r) {
+            for (size_t i = 0; i != OPERANDS; ++i) {
+                f(i);
+            }
+        }
+        std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+        return time.count() / (REPEATS * OPERANDS);
+    }
+
+    std::string random_number(std::mt19937& rng, size_t bits) {
+        big_integer res = 0;
+        for (size_t i = 0; i < bits; i += 16) {
+            res <<= 16;
+            res += static_cast<int>(rng() & 0xFFFF);
+        }
+        return to_string(res);
+    }
+
+    template <size_t Bits>
+    void run() {
+        std::mt19937 rng(Bits);
+        std::vector<std::string> a;
+        std::vector<std::string> b;
+        for (size_t i = 0; i != OPERANDS; ++i) {
+            // Half-width operands, so that the products fit into Bits
+            a.push_back(random_number(rng, Bits / 2 - 1));
+            b.push_back(random_number(rng, Bits / 4));
+        }
+
+        std::vector<fixed_int<Bits>> fa;
+        std::vector<fixed_int<Bits>> fb;
+        std::vector<big_integer> ba;
+        std::vector<big_integer> bb;
+        mpz_t* ma = new mpz_t[OPERANDS];
+        mpz_t* mb = new mpz_t[OPERANDS];
+        mpz_t mr;
+        mpz_init(mr);
+        for (size_t i = 0; i != OPERANDS; ++i) {
+            fa.emplace_back(a[i]);
+            fb.emplace_back(b[i]);
+            ba.emplace_back(a[i]);
+            bb.emplace_back(b[i]);
+            mpz_init_set_str(ma[i], a[i].c_str(), 10);
+            mpz_init_set_str(mb[i], b[i].c_str(), 10);
+        }
+
+        fixed_int<Bits> fr;
+        big_integer br;
+        std::printf("%4zu bits        fixed_int   big_integer         mpz_t\n", Bits);
+        std::printf("  add     %12.1f  %12.1f  %12.1f  ns/op\n",
+                    measure([&](size_t i) { fr = fa[i] + fb[i]; escape(fr); }),
+                    measure([&](size_t i) { br = ba[i] + bb[i]; escape(br); }),
+                    measure([&](size_t i) { mpz_add(mr, ma[i], mb[i]); }));
+        std::printf("  mul     %12.1f  %12.1f  %12.1f  ns/op\n",
+                    measure([&](size_t i) { fr = fa[i] * fb[i]; escape(fr); }),
+                    measure([&](size_t i) { br = ba[i] * bb[i]; escape(br); }),
+                    measure([&](size_t i) { mpz_mul(mr, ma[i], mb[i]); }));
+        std::printf("  div     %12.1f  %12.1f  %12.1f  ns/op\n",
+                    measure([&](size_t i) { fr = fa[i] / fb[i]; escape(fr); }),
+                    measure([&](size_t i) { br = ba[i] / bb[i]; escape(br); }),
+                    measure([&](size_t i) { mpz_tdiv_q(mr, ma[i], mb[i]); }));
+        std::printf("  cmp     %12.1f  %12.1f  %12.1f  ns/op\n",
+                    measure([&](size_t i) { bool r = fa[i] < fb[i]; escape(r); }),
+                    measure([&](size_t i) { bool r = ba[i] < bb[i]; escape(r); }),
+                    measure([&](size_t i) { int r = mpz_cmp(ma[i], mb[i]); escape(r); }));
+
+        // Keep the results observable
+        std::printf("  (%s %s)\n\n", to_string(fr).substr(0, 8).c_str(), to_string(br).substr(0, 8).c_str());
+        for (size_t i = 0; i != OPERANDS; ++i) {
+            mpz_clear(ma[i]);
+            mpz_clear(mb[i]);
+        }
+        delete[] ma;
+        delete[] mb;
+        mpz_clear(mr);
+    }
+}
+
+int main() {
+    run<128>();
+    run<256>();
+    run<512>();
+    run<1024>();
+    return 0;
+}
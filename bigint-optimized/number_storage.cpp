@@ -2,17 +2,83 @@
 
 #include <memory>
 #include <algorithm>
+#include <new>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
 
 
 // Helpful functions
 
 namespace {
+    storage_backend current_backend = storage_backend::heap;
+    size_t map_threshold = 0;
+    std::string map_directory;
+
+    size_t buffer_bytes(size_t size) {
+        return sizeof(flexible_data) + sizeof(number_storage::number_t) * size;
+    }
+
+    void* map_buffer(size_t bytes) {
+        void* ptr;
+        if (current_backend == storage_backend::temp_file) {
+            std::string name = map_directory + "/big_integer-XXXXXX";
+            std::vector<char> path(name.begin(), name.end());
+            path.push_back('\0');
+            int fd = mkstemp(path.data());
+            if (fd == -1) {
+                throw std::bad_alloc();
+            }
+            // Файл исчезнет вместе с последним отображением
+            unlink(path.data());
+            if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+                close(fd);
+                throw std::bad_alloc();
+            }
+            ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+        } else {
+            ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+#ifdef MADV_HUGEPAGE
+            if (ptr != MAP_FAILED) {
+                madvise(ptr, bytes, MADV_HUGEPAGE);
+            }
+#endif
+        }
+        if (ptr == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
     flexible_data* allocate_buffer(size_t size) {
-        auto* buf = static_cast<flexible_data*>(operator new (sizeof(flexible_data) + sizeof(number_storage::number_t) * size));
+        bool mapped = number_storage::maps(size);
+        auto* buf = static_cast<flexible_data*>(mapped ? map_buffer(buffer_bytes(size)) : operator new (buffer_bytes(size)));
+        buf->mapped = mapped;
         buf->ref_counter = 1;
         buf->capacity = size;
+        // Память сырая, атомики нужно создать
+        new (&buf->hash_size) std::atomic<size_t>(0);
+        new (&buf->hash) std::atomic<size_t>(0);
         return buf;
     }
+
+    void free_buffer(flexible_data* buf) {
+        if (buf->mapped) {
+            munmap(buf, buffer_bytes(buf->capacity));
+        } else {
+            operator delete(buf);
+        }
+    }
+
+    size_t hash_range(number_storage::const_iterator first, number_storage::const_iterator last) {
+        uint64_t hash = 0xcbf29ce484222325;
+        for (; first != last; ++first) {
+            hash = (hash ^ *first) * 0x9e3779b97f4a7c15;
+            hash ^= hash >> 29;
+        }
+        return static_cast<size_t>(hash ^ (hash >> 32));
+    }
 }
 
 // Private methods
@@ -30,8 +96,12 @@ void number_storage::init_unique_dynamic(size_t capacity) {
 }
 
 void number_storage::separate() {
-    if (sz.is_big && dynamic_data->ref_counter > 1) {
-        init_unique_dynamic(dynamic_data->capacity);
+    if (sz.is_big) {
+        if (dynamic_data->ref_counter > 1) {
+            init_unique_dynamic(dynamic_data->capacity);
+        }
+        // Буфер сейчас будут менять
+        dynamic_data->hash_size.store(0, std::memory_order_relaxed);
     }
 }
 
@@ -39,7 +109,7 @@ void number_storage::clr() {
     if (sz.is_big) {
         --dynamic_data->ref_counter;
         if (dynamic_data->ref_counter == 0) {
-            delete dynamic_data;
+            free_buffer(dynamic_data);
         }
     }
 }
@@ -66,8 +136,30 @@ number_storage::number_storage(number_storage const& other) : sz(other.sz) {
     }
 }
 
+number_storage::number_storage(number_storage&& other) noexcept : sz(other.sz) {
+    if (sz.is_big) {
+        dynamic_data = other.dynamic_data;
+    } else {
+        std::copy(other.static_data, other.static_data + MAX_STATIC_SIZE, static_data);
+    }
+    other.sz = special_size(1, false);
+    other.static_data[0] = 0;
+}
+
+number_storage& number_storage::operator=(number_storage&& other) noexcept {
+    if (this != &other) {
+        clr();
+        new (this) number_storage(std::move(other));
+    }
+    return *this;
+}
+
 number_storage& number_storage::operator=(number_storage const& other) {
-    if (this != & other) {
+    if (!sz.is_big && other.size() <= MAX_STATIC_SIZE) {
+        // Без копии и обмена : оба значения помещаются в static_data
+        std::copy(other.begin(), other.end(), static_data);
+        sz.size = other.size();
+    } else if (this != & other) {
         number_storage tmp(other);
         swap(tmp);
     }
@@ -86,10 +178,6 @@ number_storage::number_t& number_storage::operator[](size_t i) {
     return static_data[i];
 }
 
-number_storage::number_t const& number_storage::operator[](size_t i) const {
-    return sz.is_big ?  dynamic_data->data[i] : static_data[i];
-}
-
 number_storage::iterator number_storage::begin() {
     if (sz.is_big) {
         separate();
@@ -106,21 +194,21 @@ number_storage::iterator number_storage::end() {
     return static_data + sz.size;
 }
 
-number_storage::const_iterator number_storage::begin() const {
-    return sz.is_big ? dynamic_data->data : static_data;
+size_t number_storage::capacity() const {
+    return sz.is_big ? dynamic_data->capacity : MAX_STATIC_SIZE;
 }
 
-number_storage::const_iterator number_storage::end() const {
-    return sz.is_big ? dynamic_data->data + sz.size : static_data + sz.size;
-}
-
-size_t number_storage::size() const {
-    return sz.size;
+void number_storage::reserve(size_t capacity) {
+    if (capacity > this->capacity()) {
+        init_unique_dynamic(capacity);
+    }
 }
 
 void number_storage::resize(size_t size, number_t val) {
     if ((sz.is_big && size > dynamic_data->capacity) || (!sz.is_big && size > MAX_STATIC_SIZE)) {
         init_unique_dynamic(INCREASE_CAPACITY * size);
+    } else if (size > sz.size) {
+        separate();
     }
     if (size > sz.size) {
         if (sz.is_big) {
@@ -139,10 +227,6 @@ number_storage::number_t& number_storage::back() {
     return sz.is_big ? dynamic_data->data[sz.size - 1] : static_data[sz.size - 1];
 }
 
-number_storage::number_t const& number_storage::back() const {
-    return sz.is_big ? dynamic_data->data[sz.size - 1] : static_data[sz.size - 1];
-}
-
 void number_storage::push_back(number_t const& val) {
     if (!sz.is_big && sz.size + 1 <= MAX_STATIC_SIZE) {
         static_data[sz.size] = val;
@@ -161,8 +245,21 @@ void number_storage::pop_back() {
     --sz.size;
 }
 
-bool number_storage::empty() const {
-    return sz.size == 0;
+void number_storage::assign(big_number_t value) {
+    size_t size = (value >> 32) != 0 ? 2 : 1;
+    if (!sz.is_big && size > MAX_STATIC_SIZE) {
+        init_unique_dynamic(INCREASE_CAPACITY * size);
+    }
+    number_t* data = static_data;
+    if (sz.is_big) {
+        separate();
+        data = dynamic_data->data;
+    }
+    data[0] = static_cast<number_t>(value);
+    if (size == 2) {
+        data[1] = static_cast<number_t>(value >> 32);
+    }
+    sz.size = size;
 }
 
 void number_storage::swap(number_storage& other) {
@@ -185,3 +282,50 @@ void number_storage::swap(number_storage& other) {
     }
     std::swap(sz, other.sz);
 }
+
+size_t number_storage::hash() const {
+    if (!sz.is_big) {
+        return hash_range(begin(), end());
+    }
+    size_t const HASH_BUSY = SIZE_MAX;
+    std::atomic<size_t>& hash_size = dynamic_data->hash_size;
+    size_t cached_size = hash_size.load(std::memory_order_acquire);
+    if (cached_size == sz.size) {
+        size_t hash = dynamic_data->hash.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (hash_size.load(std::memory_order_relaxed) == sz.size) {
+            return hash;
+        }
+    }
+    size_t hash = hash_range(begin(), end());
+    // Кэш обновляет только один поток, остальные просто возвращают посчитанное
+    if (cached_size != HASH_BUSY &&
+        hash_size.compare_exchange_strong(cached_size, HASH_BUSY, std::memory_order_relaxed)) {
+        std::atomic_thread_fence(std::memory_order_release);
+        dynamic_data->hash.store(hash, std::memory_order_relaxed);
+        hash_size.store(sz.size, std::memory_order_release);
+    }
+    return hash;
+}
+
+bool number_storage::shares_data(number_storage const& other) const {
+    return sz.is_big && other.sz.is_big && dynamic_data == other.dynamic_data && sz.size == other.sz.size;
+}
+
+void number_storage::set_storage_backend(storage_backend backend, size_t threshold, std::string const& directory) {
+    current_backend = backend;
+    map_threshold = threshold;
+    map_directory = directory;
+}
+
+bool number_storage::maps(size_t size) {
+    return current_backend != storage_backend::heap && size >= map_threshold;
+}
+
+size_t number_storage::mapping_threshold() {
+    return map_threshold;
+}
+
+bool number_storage::is_mapped() const {
+    return sz.is_big && dynamic_data->mapped;
+}
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <utility>
 #include <cstddef>
+#include <string>
 
 
 struct special_size {
@@ -16,14 +18,36 @@ struct special_size {
 };
 
 // Специально уменьшаю capacity до 63 бит, чтобы сохранялся инвариант: capacity >= size.
+// Оставшийся бит отмечает буферы, размещённые через mmap.
+
+// Хеш первых hash_size элементов кэшируется в самом буфере и поэтому общий для всех копий.
+// hash_size = 0 — хеш не посчитан (динамический буфер всегда хранит больше элементов).
+// Общий буфер хешируют из разных потоков, поэтому кэш — seqlock : писатель захватывает
+// hash_size, заменяя его на HASH_BUSY, пишет hash и публикует новый hash_size,
+// читатель верит hash, только если hash_size до и после чтения равен его размеру.
 
 struct flexible_data {
     size_t capacity : special_size::SIZE_BITS;
+    bool mapped : 1;
     size_t ref_counter;
+    std::atomic<size_t> hash_size;
+    std::atomic<size_t> hash;
     uint32_t data[];
 };
 
 
+// Где размещаются буферы от порога и больше :
+// heap — operator new,
+// anonymous_mapping — анонимный mmap без резервирования swap с просьбой использовать huge pages,
+// temp_file — mmap удалённого временного файла, страницы вытесняются в файл, а не в swap.
+
+enum class storage_backend {
+    heap,
+    anonymous_mapping,
+    temp_file
+};
+
+
 struct number_storage {
     using number_t = uint32_t;
     using big_number_t = uint64_t;
@@ -33,7 +57,10 @@ struct number_storage {
     number_storage() = default;
     explicit number_storage(size_t size, number_t val = 0);
     number_storage(number_storage const& other);
+    // Забирает буфер other, в other остаётся один нулевой элемент
+    number_storage(number_storage&& other) noexcept;
     number_storage& operator=(number_storage const& other);
+    number_storage& operator=(number_storage&& other) noexcept;
 
     ~number_storage();
 
@@ -47,6 +74,10 @@ struct number_storage {
     const_iterator end() const;
 
     size_t size() const;
+    size_t capacity() const;
+
+    // Гарантирует capacity >= capacity', чтобы последующие resize не перевыделяли память
+    void reserve(size_t capacity);
 
     // Если size' > size : i = size ... size' - 1 : elements[i] = val
     void resize(size_t size, number_t val = 0);
@@ -59,6 +90,26 @@ struct number_storage {
     bool empty() const;
     void swap(number_storage&);
 
+    // Хранилище становится числом value из одного или двух элементов
+    void assign(big_number_t value);
+
+    // Хеш элементов, для динамического буфера он считается один раз до первого изменения
+    size_t hash() const;
+    // true, если оба хранилища ссылаются на один буфер и имеют одинаковый размер
+    bool shares_data(number_storage const& other) const;
+
+    // Буферы из threshold и более элементов будут размещаться в backend, уже созданные не переносятся.
+    // Порог должен быть порядка свободной памяти : каждый такой буфер — отдельный mmap (для temp_file
+    // ещё и файл), а произведения в нём считаются блоками по max(threshold / 4, KARATSUBA_CUTOFF)
+    // элементов, так что маленький порог делает умножение почти школьным.
+    // Нельзя вызывать, пока другие потоки создают числа.
+    static void set_storage_backend(storage_backend backend, size_t threshold,
+                                    std::string const& directory = "/tmp");
+    // true, если буфер такого размера будет размещён через mmap
+    static bool maps(size_t size);
+    static size_t mapping_threshold();
+    bool is_mapped() const;
+
  private:
     constexpr static uint8_t MAX_STATIC_SIZE = sizeof(flexible_data*) / sizeof(number_t);
     constexpr static uint8_t INCREASE_CAPACITY = 2;
@@ -74,5 +125,28 @@ struct number_storage {
     void clr();
 };
 
+// Константные методы вызываются на каждой операции с числом, поэтому они в заголовке
+
+inline number_storage::number_t const& number_storage::operator[](size_t i) const {
+    return sz.is_big ? dynamic_data->data[i] : static_data[i];
+}
+
+inline number_storage::const_iterator number_storage::begin() const {
+    return sz.is_big ? dynamic_data->data : static_data;
+}
+
+inline number_storage::const_iterator number_storage::end() const {
+    return sz.is_big ? dynamic_data->data + sz.size : static_data + sz.size;
+}
+
+inline size_t number_storage::size() const {
+    return sz.size;
+}
 
+inline number_storage::number_t const& number_storage::back() const {
+    return sz.is_big ? dynamic_data->data[sz.size - 1] : static_data[sz.size - 1];
+}
 
+inline bool number_storage::empty() const {
+    return sz.size == 0;
+}
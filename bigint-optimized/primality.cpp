@@ -0,0 +1,512 @@
+#include "primality.h"
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+// Helpful functions
+
+namespace {
+    using number_t = number_storage::number_t;
+    using big_number_t = number_storage::big_number_t;
+    using const_iterator = number_storage::const_iterator;
+    using limbs_t = std::vector<number_t>;
+
+    constexpr big_number_t BASE = static_cast<big_number_t>(UINT32_MAX) + 1;
+
+    // Trial division uses all odd primes below this bound
+    constexpr number_t TRIAL_LIMIT = 2048;
+    // Selfridge's search for D stops after a few steps unless n is a perfect square
+    constexpr int SQUARE_CHECK_STEP = 8;
+
+    // Neighbouring primes are grouped so that the product of a group fits into number_t,
+    // then one division per group and limb is enough to get the remainders for all of them.
+    struct prime_group {
+        number_t product;
+        std::vector<number_t> primes;
+    };
+
+    struct trial_table {
+        std::vector<number_t> primes;
+        std::vector<prime_group> groups;
+
+        trial_table() {
+            std::vector<bool> composite(TRIAL_LIMIT);
+            for (number_t i = 3; i < TRIAL_LIMIT; i += 2) {
+                if (!composite[i]) {
+                    primes.push_back(i);
+                    for (number_t j = i * i; j < TRIAL_LIMIT; j += 2 * i) {
+                        composite[j] = true;
+                    }
+                }
+            }
+            for (number_t p : primes) {
+                if (groups.empty() || static_cast<big_number_t>(groups.back().product) * p >= BASE) {
+                    groups.push_back({1, {}});
+                }
+                groups.back().product *= p;
+                groups.back().primes.push_back(p);
+            }
+        }
+    };
+
+    trial_table const& small_primes() {
+        static trial_table const table;
+        return table;
+    }
+
+    number_t mod_small(const_iterator lng, size_t size, number_t m) {
+        big_number_t rem = 0;
+        for (size_t i = size; i != 0; ) {
+            rem = (rem * BASE + lng[--i]) % m;
+        }
+        return static_cast<number_t>(rem);
+    }
+
+    // Remainders modulo every group product, computed in a single pass over the limbs
+    std::vector<number_t> group_remainders(const_iterator lng, size_t size) {
+        auto const& groups = small_primes().groups;
+        std::vector<number_t> rem(groups.size());
+        for (size_t i = size; i != 0; ) {
+            number_t limb = lng[--i];
+            for (size_t g = 0; g != groups.size(); ++g) {
+                rem[g] = static_cast<number_t>((rem[g] * BASE + limb) % groups[g].product);
+            }
+        }
+        return rem;
+    }
+
+    bool has_small_factor(const_iterator lng, size_t size) {
+        auto const& groups = small_primes().groups;
+        std::vector<number_t> rem = group_remainders(lng, size);
+        for (size_t g = 0; g != groups.size(); ++g) {
+            for (number_t p : groups[g].primes) {
+                if (rem[g] % p == 0) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    size_t trailing_zeros(const_iterator lng, size_t size) {
+        size_t i = 0;
+        while (i != size && lng[i] == 0) {
+            ++i;
+        }
+        return i == size ? 0 : 32 * i + __builtin_ctz(lng[i]);
+    }
+
+    size_t bit_length(const_iterator lng, size_t size) {
+        while (size != 0 && lng[size - 1] == 0) {
+            --size;
+        }
+        return size == 0 ? 0 : 32 * size - __builtin_clz(lng[size - 1]);
+    }
+
+    bool test_bit(const_iterator lng, size_t i) {
+        return (lng[i / 32] >> (i % 32)) & 1;
+    }
+
+    limbs_t to_limbs(const_iterator lng, size_t size, size_t k) {
+        limbs_t res(k);
+        std::copy(lng, lng + std::min(size, k), res.begin());
+        return res;
+    }
+
+    // Jacobi symbol (a / n), n is odd and positive
+    int jacobi(int64_t a, const_iterator n, size_t size) {
+        int result = 1;
+        number_t n8 = n[0] % 8;
+        if (a < 0) {
+            a = -a;
+            if (n8 % 4 == 3) {
+                result = -result;
+            }
+        }
+        while (a % 2 == 0) {
+            a /= 2;
+            if (n8 == 3 || n8 == 5) {
+                result = -result;
+            }
+        }
+        if (a == 1) {
+            return result;
+        }
+        // Quadratic reciprocity : (a / n) = (n mod a / a) up to the sign
+        if (a % 4 == 3 && n8 % 4 == 3) {
+            result = -result;
+        }
+        uint64_t x = mod_small(n, size, static_cast<number_t>(a));
+        uint64_t y = static_cast<uint64_t>(a);
+        while (x != 0) {
+            while (x % 2 == 0) {
+                x /= 2;
+                if (y % 8 == 3 || y % 8 == 5) {
+                    result = -result;
+                }
+            }
+            std::swap(x, y);
+            if (x % 4 == 3 && y % 4 == 3) {
+                result = -result;
+            }
+            x %= y;
+        }
+        return y == 1 ? result : 0;
+    }
+
+    bool is_square(big_integer const& n, size_t size) {
+        big_integer x = big_integer(1) << static_cast<int>(16 * size);
+        while (true) {
+            big_integer y = (x + n / x) >> 1;
+            if (y >= x) {
+                break;
+            }
+            x = y;
+        }
+        return x * x == n;
+    }
+
+    // Arithmetic modulo odd n on numbers of exactly k limbs in Montgomery form x * R mod n, R = BASE^k.
+    struct montgomery {
+        // r2 = R^2 mod n
+        montgomery(const_iterator n, size_t k, limbs_t r2) : n_(n, n + k), r2_(std::move(r2)), t_(k + 2) {
+            // Newton's iteration doubles the number of correct low bits of n^(-1) mod BASE
+            number_t inv = n_[0];
+            for (int i = 0; i != 5; ++i) {
+                inv *= 2 - n_[0] * inv;
+            }
+            n_inv_ = -inv;
+
+            limbs_t unit(k);
+            unit[0] = 1;
+            one_ = to_mont(unit);
+            minus_one_ = limbs_t(k);
+            sub(minus_one_, one_, minus_one_);
+        }
+
+        size_t size() const {
+            return n_.size();
+        }
+
+        limbs_t const& one() const {
+            return one_;
+        }
+
+        limbs_t const& minus_one() const {
+            return minus_one_;
+        }
+
+        limbs_t to_mont(limbs_t const& a) const {
+            limbs_t res(size());
+            mul(a, r2_, res);
+            return res;
+        }
+
+        limbs_t from_int(int64_t a) const {
+            limbs_t res(size());
+            res[0] = static_cast<number_t>(a < 0 ? -a : a);
+            res = to_mont(res);
+            if (a < 0) {
+                sub(limbs_t(size()), res, res);
+            }
+            return res;
+        }
+
+        // res = a * b / R mod n, res may coincide with a or b
+        void mul(limbs_t const& a, limbs_t const& b, limbs_t& res) const {
+            size_t k = size();
+            std::fill(t_.begin(), t_.end(), 0);
+            for (size_t i = 0; i != k; ++i) {
+                big_number_t carry = 0;
+                for (size_t j = 0; j != k; ++j) {
+                    big_number_t cur = t_[j] + static_cast<big_number_t>(a[j]) * b[i] + carry;
+                    t_[j] = static_cast<number_t>(cur % BASE);
+                    carry = cur / BASE;
+                }
+                big_number_t cur = t_[k] + carry;
+                t_[k] = static_cast<number_t>(cur % BASE);
+                t_[k + 1] = static_cast<number_t>(cur / BASE);
+
+                // Add m * n so that the lowest limb becomes zero and drop it
+                number_t m = t_[0] * n_inv_;
+                cur = t_[0] + static_cast<big_number_t>(m) * n_[0];
+                carry = cur / BASE;
+                for (size_t j = 1; j != k; ++j) {
+                    cur = t_[j] + static_cast<big_number_t>(m) * n_[j] + carry;
+                    t_[j - 1] = static_cast<number_t>(cur % BASE);
+                    carry = cur / BASE;
+                }
+                cur = t_[k] + carry;
+                t_[k - 1] = static_cast<number_t>(cur % BASE);
+                t_[k] = t_[k + 1] + static_cast<number_t>(cur / BASE);
+            }
+            if (t_[k] != 0 || !less(t_.data(), n_.data())) {
+                sub_n(t_.data());
+            }
+            std::copy(t_.begin(), t_.begin() + k, res.begin());
+        }
+
+        void sqr(limbs_t& a) const {
+            mul(a, a, a);
+        }
+
+        void add(limbs_t const& a, limbs_t const& b, limbs_t& res) const {
+            big_number_t carry = 0;
+            for (size_t j = 0; j != size(); ++j) {
+                big_number_t cur = carry + a[j] + b[j];
+                res[j] = static_cast<number_t>(cur % BASE);
+                carry = cur / BASE;
+            }
+            if (carry != 0 || !less(res.data(), n_.data())) {
+                sub_n(res.data());
+            }
+        }
+
+        void sub(limbs_t const& a, limbs_t const& b, limbs_t& res) const {
+            big_number_t borrow = 0;
+            for (size_t j = 0; j != size(); ++j) {
+                big_number_t cur = BASE - borrow + a[j] - b[j];
+                res[j] = static_cast<number_t>(cur % BASE);
+                borrow = 1 - cur / BASE;
+            }
+            if (borrow != 0) {
+                big_number_t carry = 0;
+                for (size_t j = 0; j != size(); ++j) {
+                    big_number_t cur = carry + res[j] + n_[j];
+                    res[j] = static_cast<number_t>(cur % BASE);
+                    carry = cur / BASE;
+                }
+            }
+        }
+
+        // a' = a / 2 mod n
+        void half(limbs_t& a) const {
+            size_t k = size();
+            big_number_t carry = 0;
+            if (a[0] & 1) {
+                for (size_t j = 0; j != k; ++j) {
+                    big_number_t cur = carry + a[j] + n_[j];
+                    a[j] = static_cast<number_t>(cur % BASE);
+                    carry = cur / BASE;
+                }
+            }
+            for (size_t j = 0; j + 1 != k; ++j) {
+                a[j] = (a[j] >> 1) | (a[j + 1] << 31);
+            }
+            a[k - 1] = (a[k - 1] >> 1) | static_cast<number_t>(carry << 31);
+        }
+
+        // res = base^e, left-to-right binary method
+        void pow(limbs_t const& base, const_iterator e, size_t e_size, limbs_t& res) const {
+            res = one_;
+            for (size_t i = bit_length(e, e_size); i != 0; ) {
+                sqr(res);
+                if (test_bit(e, --i)) {
+                    mul(res, base, res);
+                }
+            }
+        }
+
+     private:
+        limbs_t n_;
+        limbs_t r2_;
+        limbs_t one_;
+        limbs_t minus_one_;
+        number_t n_inv_;
+        mutable limbs_t t_;
+
+        bool less(number_t const* a, number_t const* b) const {
+            for (size_t j = size(); j != 0; ) {
+                --j;
+                if (a[j] != b[j]) {
+                    return a[j] < b[j];
+                }
+            }
+            return false;
+        }
+
+        void sub_n(number_t* a) const {
+            big_number_t borrow = 0;
+            for (size_t j = 0; j != size(); ++j) {
+                big_number_t cur = BASE - borrow + a[j] - n_[j];
+                a[j] = static_cast<number_t>(cur % BASE);
+                borrow = 1 - cur / BASE;
+            }
+        }
+    };
+
+    // n - 1 = d * 2^s, d is odd
+    bool strong_fermat(montgomery const& m, limbs_t const& base, const_iterator d, size_t d_size, size_t s) {
+        limbs_t x(m.size());
+        m.pow(base, d, d_size, x);
+        if (x == m.one() || x == m.minus_one()) {
+            return true;
+        }
+        for (size_t r = 1; r < s; ++r) {
+            m.sqr(x);
+            if (x == m.minus_one()) {
+                return true;
+            }
+            if (x == m.one()) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool is_zero(limbs_t const& a) {
+        return std::all_of(a.begin(), a.end(), [](number_t x) { return x == 0; });
+    }
+
+    // Strong Lucas test with P = 1, Q = (1 - D) / 4; n + 1 = d * 2^s, d is odd
+    bool strong_lucas(montgomery const& m, int64_t D, const_iterator d, size_t d_size, size_t s) {
+        limbs_t Dm = m.from_int(D);
+        limbs_t Q = m.from_int((1 - D) / 4);
+        limbs_t U = m.one();
+        limbs_t V = m.one();
+        limbs_t Qk = Q;
+        limbs_t DU(m.size());
+        for (size_t i = bit_length(d, d_size) - 1; i != 0; ) {
+            // k' = 2k : U' = U * V, V' = V^2 - 2Q^k
+            m.mul(U, V, U);
+            m.sqr(V);
+            m.sub(V, Qk, V);
+            m.sub(V, Qk, V);
+            m.sqr(Qk);
+            if (test_bit(d, --i)) {
+                // k' = k + 1 : U' = (U + V) / 2, V' = (D * U + V) / 2
+                m.mul(U, Dm, DU);
+                m.add(U, V, U);
+                m.half(U);
+                m.add(DU, V, V);
+                m.half(V);
+                m.mul(Qk, Q, Qk);
+            }
+        }
+        if (is_zero(U) || is_zero(V)) {
+            return true;
+        }
+        for (size_t r = 1; r < s; ++r) {
+            m.sqr(V);
+            m.sub(V, Qk, V);
+            m.sub(V, Qk, V);
+            if (is_zero(V)) {
+                return true;
+            }
+            m.sqr(Qk);
+        }
+        return false;
+    }
+}
+
+bool is_probable_prime(big_integer const& n, unsigned rounds) {
+    auto const& primes = small_primes().primes;
+    if (n.sign_ || n.is_zero()) {
+        return false;
+    }
+    size_t k = n.val_.size();
+    if (k == 1 && n.val_[0] < TRIAL_LIMIT) {
+        return n.val_[0] == 2 || std::binary_search(primes.begin(), primes.end(), n.val_[0]);
+    }
+    if (n.val_[0] % 2 == 0 || has_small_factor(n.val_.begin(), k)) {
+        return false;
+    }
+    if (k == 1 && n.val_[0] < TRIAL_LIMIT * TRIAL_LIMIT) {
+        return true;
+    }
+
+    big_integer r2 = (big_integer(1) << static_cast<int>(64 * k)) % n;
+    montgomery m(n.val_.begin(), k, to_limbs(r2.val_.begin(), r2.val_.size(), k));
+
+    big_integer d = n - 1;
+    size_t s = trailing_zeros(d.val_.begin(), d.val_.size());
+    d >>= static_cast<int>(s);
+    limbs_t two(k);
+    m.add(m.one(), m.one(), two);
+    if (!strong_fermat(m, two, d.val_.begin(), d.val_.size(), s)) {
+        return false;
+    }
+
+    // Selfridge : the first D in 5, -7, 9, -11, ... with (D / n) = -1
+    int64_t D = 5;
+    for (int step = 1; ; ++step) {
+        int j = jacobi(D, n.val_.begin(), k);
+        if (j == -1) {
+            break;
+        }
+        if (j == 0) {
+            return false;
+        }
+        if (step == SQUARE_CHECK_STEP && is_square(n, k)) {
+            return false;
+        }
+        D = D > 0 ? -(D + 2) : -D + 2;
+    }
+    d = n + 1;
+    s = trailing_zeros(d.val_.begin(), d.val_.size());
+    d >>= static_cast<int>(s);
+    if (!strong_lucas(m, D, d.val_.begin(), d.val_.size(), s)) {
+        return false;
+    }
+
+    if (rounds != 0) {
+        d = n - 1;
+        s = trailing_zeros(d.val_.begin(), d.val_.size());
+        d >>= static_cast<int>(s);
+        big_integer range = n - 3;
+        std::mt19937 rng(n.val_[0]);
+        for (unsigned round = 0; round != rounds; ++round) {
+            // base in [2, n - 2]
+            big_integer base(0, k);
+            for (size_t i = 0; i != k; ++i) {
+                base.val_[i] = rng();
+            }
+            base.clear_back();
+            base %= range;
+            base += 2;
+            limbs_t base_m = m.to_mont(to_limbs(base.val_.begin(), base.val_.size(), k));
+            if (!strong_fermat(m, base_m, d.val_.begin(), d.val_.size(), s)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+big_integer next_prime(big_integer const& n) {
+    auto const& primes = small_primes().primes;
+    if (n.sign_ || n < 2) {
+        return 2;
+    }
+    if (n < static_cast<int>(primes.back())) {
+        return static_cast<int>(*std::upper_bound(primes.begin(), primes.end(), n.val_[0]));
+    }
+
+    // Sieve the odd candidates : the remainders modulo the small primes are
+    // computed once and then advanced together with the candidate.
+    big_integer c = n + 1;
+    if (c.val_[0] % 2 == 0) {
+        c += 1;
+    }
+    auto const& groups = small_primes().groups;
+    std::vector<number_t> group_rem = group_remainders(c.val_.begin(), c.val_.size());
+    std::vector<number_t> rem;
+    for (size_t g = 0; g != groups.size(); ++g) {
+        for (number_t p : groups[g].primes) {
+            rem.push_back(group_rem[g] % p);
+        }
+    }
+    while (true) {
+        if (std::find(rem.begin(), rem.end(), 0) == rem.end() && is_probable_prime(c)) {
+            return c;
+        }
+        c += 2;
+        for (size_t i = 0; i != rem.size(); ++i) {
+            rem[i] += 2;
+            if (rem[i] >= primes[i]) {
+                rem[i] -= primes[i];
+            }
+        }
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "big_integer.h"
+
+// Baillie–PSW test (trial division, strong Fermat test to base 2 and strong
+// Lucas test with Selfridge parameters) followed by `rounds` extra
+// Miller–Rabin rounds with pseudo-random bases. No BPSW pseudoprime is known.
+bool is_probable_prime(big_integer const& n, unsigned rounds = 0);
+
+// Smallest probable prime > n
+big_integer next_prime(big_integer const& n);
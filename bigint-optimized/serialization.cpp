@@ -0,0 +1,144 @@
+#include "serialization.h"
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+// Helpful functions
+
+namespace {
+    void write_varint(std::vector<char>& buf, uint64_t val) {
+        while (val >= 0x80) {
+            buf.push_back(static_cast<char>((val & 0x7F) | 0x80));
+            val >>= 7;
+        }
+        buf.push_back(static_cast<char>(val));
+    }
+
+    uint64_t read_varint(std::istream& s) {
+        uint64_t res = 0;
+        for (uint32_t shift = 0; shift < 64; shift += 7) {
+            int byte = s.get();
+            if (byte == std::istream::traits_type::eof()) {
+                throw std::runtime_error("Unexpected end of stream");
+            }
+            // The 10th byte holds only the top bit of 64
+            if (shift == 63 && (byte & 0x7E) != 0) {
+                throw std::runtime_error("Malformed length");
+            }
+            res |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return res;
+            }
+        }
+        throw std::runtime_error("Malformed length");
+    }
+
+    void append(std::vector<char>& buf, big_integer const& a) {
+        std::vector<uint8_t> bytes = export_bytes(a);
+        write_varint(buf, (static_cast<uint64_t>(bytes.size()) << 1) | (a < 0));
+        buf.insert(buf.end(), bytes.begin(), bytes.end());
+    }
+
+    void flush(std::ostream& s, std::vector<char>& buf) {
+        s.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        buf.clear();
+    }
+}
+
+std::vector<uint32_t> export_limbs(big_integer const& a) {
+    if (a.is_zero()) {
+        return std::vector<uint32_t>();
+    }
+    return std::vector<uint32_t>(a.val_.begin(), a.val_.end());
+}
+
+big_integer import_limbs(uint32_t const* data, size_t size, bool negative) {
+    big_integer res(0, std::max(size, static_cast<size_t>(1)));
+    std::copy(data, data + size, res.val_.begin());
+    res.sign_ = negative;
+    res.clear_back();
+    return res;
+}
+
+std::vector<uint8_t> export_bytes(big_integer const& a, byte_order order) {
+    std::vector<uint8_t> res;
+    if (a.is_zero()) {
+        return res;
+    }
+    size_t size = (a.val_.size() - 1) * 4;
+    for (uint32_t top = a.val_.back(); top != 0; top >>= 8) {
+        ++size;
+    }
+    res.resize(size);
+    number_storage::const_iterator limbs = a.val_.begin();
+    for (size_t i = 0; i != size; ++i) {
+        res[i] = static_cast<uint8_t>(limbs[i / 4] >> (8 * (i % 4)));
+    }
+    if (order == byte_order::big_endian) {
+        std::reverse(res.begin(), res.end());
+    }
+    return res;
+}
+
+big_integer import_bytes(uint8_t const* data, size_t size, byte_order order, bool negative) {
+    big_integer res(0, std::max((size + 3) / 4, static_cast<size_t>(1)));
+    number_storage::iterator limbs = res.val_.begin();
+    for (size_t i = 0; i != size; ++i) {
+        uint32_t byte = order == byte_order::little_endian ? data[i] : data[size - 1 - i];
+        limbs[i / 4] |= byte << (8 * (i % 4));
+    }
+    res.sign_ = negative;
+    res.clear_back();
+    return res;
+}
+
+void write_binary(std::ostream& s, big_integer const& a) {
+    std::vector<char> buf;
+    append(buf, a);
+    flush(s, buf);
+}
+
+big_integer read_binary(std::istream& s) {
+    // The length comes from the stream, so the buffer grows only as the bytes arrive
+    constexpr uint64_t CHUNK_SIZE = 1 << 16;
+    uint64_t header = read_varint(s);
+    uint64_t length = header >> 1;
+    std::vector<uint8_t> bytes;
+    while (bytes.size() != length) {
+        size_t chunk = static_cast<size_t>(std::min(length - bytes.size(), CHUNK_SIZE));
+        size_t offset = bytes.size();
+        bytes.resize(offset + chunk);
+        s.read(reinterpret_cast<char*>(bytes.data() + offset), static_cast<std::streamsize>(chunk));
+        if (static_cast<size_t>(s.gcount()) != chunk) {
+            throw std::runtime_error("Unexpected end of stream");
+        }
+    }
+    return import_bytes(bytes.data(), bytes.size(), byte_order::little_endian, header & 1);
+}
+
+void write_binary(std::ostream& s, std::vector<big_integer> const& v) {
+    // Small numbers are gathered into one block to avoid a write per element
+    constexpr size_t BLOCK_SIZE = 1 << 16;
+    std::vector<char> buf;
+    write_varint(buf, v.size());
+    for (auto const& a : v) {
+        append(buf, a);
+        if (buf.size() >= BLOCK_SIZE) {
+            flush(s, buf);
+        }
+    }
+    flush(s, buf);
+}
+
+std::vector<big_integer> read_binary_vector(std::istream& s) {
+    uint64_t size = read_varint(s);
+    std::vector<big_integer> res;
+    // The size comes from the stream, so it isn't trusted for reserve
+    res.reserve(static_cast<size_t>(std::min(size, static_cast<uint64_t>(1 << 16))));
+    for (uint64_t i = 0; i != size; ++i) {
+        res.push_back(read_binary(s));
+    }
+    return res;
+}
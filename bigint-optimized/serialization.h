@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+#include "big_integer.h"
+
+// Binary formats in the spirit of mpz_import / mpz_export : only the magnitude
+// is converted, the sign is passed separately. Leading zeros are dropped on
+// export and allowed on import. Everything is linear in the length.
+
+enum class byte_order {
+    little_endian,
+    big_endian
+};
+
+std::vector<uint8_t> export_bytes(big_integer const& a, byte_order order = byte_order::little_endian);
+big_integer import_bytes(uint8_t const* data, size_t size, byte_order order = byte_order::little_endian,
+                         bool negative = false);
+
+// 32-bit limbs, least significant first
+std::vector<uint32_t> export_limbs(big_integer const& a);
+big_integer import_limbs(uint32_t const* data, size_t size, bool negative = false);
+
+// Stream format : varint (number of bytes * 2 + sign), then the magnitude in
+// little-endian bytes. A vector is written as varint (size) and its elements.
+// Reading throws std::runtime_error on a truncated or malformed stream.
+void write_binary(std::ostream& s, big_integer const& a);
+big_integer read_binary(std::istream& s);
+
+void write_binary(std::ostream& s, std::vector<big_integer> const& v);
+std::vector<big_integer> read_binary_vector(std::istream& s);
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <gmp.h>
+
+#include "big_integer.h"
+
+// Mixed workload : most operands fit into a machine word, the rest are 256-bit
+// numbers. Every operation is applied to OPERANDS pairs, the time per operation
+// is printed for big_integer and GMP's mpz_t.
+
+namespace {
+    size_t const OPERANDS = 4096;
+    size_t const REPEATS = 200;
+
+    // Makes the compiler assume that the value is read and written
+    template <typename T>
+    void escape(T& value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    template <typename F>
+    double measure(F const& f) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r != REPEATS; ++r) {
+            for (size_t i = 0; i != OPERANDS; ++i) {
+                f(i);
+            }
+        }
+        std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+        return time.count() / (REPEATS * OPERANDS);
+    }
+
+    std::string random_number(std::mt19937& rng, int large_percent) {
+        std::string sign = rng() % 2 ? "-" : "";
+        if (static_cast<int>(rng() % 100) >= large_percent) {
+            return sign + std::to_string(rng() % 1000000 + 1);
+        }
+        big_integer res = 1;
+        for (int i = 0; i != 16; ++i) {
+            res <<= 16;
+            res += static_cast<int>(rng() & 0xFFFF);
+        }
+        return sign + to_string(res);
+    }
+
+    void run(int large_percent) {
+        std::mt19937 rng(39);
+        std::vector<big_integer> a;
+        std::vector<big_integer> b;
+        mpz_t* ma = new mpz_t[OPERANDS];
+        mpz_t* mb = new mpz_t[OPERANDS];
+        mpz_t mr;
+        mpz_init(mr);
+        for (size_t i = 0; i != OPERANDS; ++i) {
+            std::string x = random_number(rng, large_percent);
+            std::string y = random_number(rng, large_percent);
+            a.emplace_back(x);
+            b.emplace_back(y);
+            mpz_init_set_str(ma[i], x.c_str(), 10);
+            mpz_init_set_str(mb[i], y.c_str(), 10);
+        }
+
+        big_integer r;
+        std::printf("%2d%% large     big_integer         mpz_t\n", large_percent);
+        std::printf("  add     %12.1f  %12.1f  ns/op\n",
+                    measure([&](size_t i) { r = a[i] + b[i]; escape(r); }),
+                    measure([&](size_t i) { mpz_add(mr, ma[i], mb[i]); }));
+        std::printf("  sub     %12.1f  %12.1f  ns/op\n",
+                    measure([&](size_t i) { r = a[i] - b[i]; escape(r); }),
+                    measure([&](size_t i) { mpz_sub(mr, ma[i], mb[i]); }));
+        std::printf("  mul     %12.1f  %12.1f  ns/op\n",
+                    measure([&](size_t i) { r = a[i] * b[i]; escape(r); }),
+                    measure([&](size_t i) { mpz_mul(mr, ma[i], mb[i]); }));
+        std::printf("  div     %12.1f  %12.1f  ns/op\n",
+                    measure([&](size_t i) { r = a[i] / b[i]; escape(r); }),
+                    measure([&](size_t i) { mpz_tdiv_q(mr, ma[i], mb[i]); }));
+        std::printf("  mod     %12.1f  %12.1f  ns/op\n",
+                    measure([&](size_t i) { r = a[i] % b[i]; escape(r); }),
+                    measure([&](size_t i) { mpz_tdiv_r(mr, ma[i], mb[i]); }));
+        std::printf("  cmp     %12.1f  %12.1f  ns/op\n",
+                    measure([&](size_t i) { bool c = a[i] < b[i]; escape(c); }),
+                    measure([&](size_t i) { int c = mpz_cmp(ma[i], mb[i]); escape(c); }));
+
+        for (size_t i = 0; i != OPERANDS; ++i) {
+            mpz_clear(ma[i]);
+            mpz_clear(mb[i]);
+        }
+        delete[] ma;
+        delete[] mb;
+        mpz_clear(mr);
+    }
+}
+
+int main() {
+    run(0);
+    run(5);
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "thread_pool.h"
+
+
+// Helpful functions
+
+namespace {
+    thread_local thread_pool const* current_pool = nullptr;
+    thread_local size_t current_queue = 0;
+}
+
+// Private methods
+
+size_t thread_pool::own_queue() const {
+    return current_pool == this ? current_queue : queues_.size() - 1;
+}
+
+bool thread_pool::pop(size_t index, task_t& task) {
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        auto& tasks = queues_[index]->tasks;
+        if (!tasks.empty()) {
+            task = std::move(tasks.back());
+            tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i != queues_.size(); ++i) {
+        task_queue& victim = *queues_[(index + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool thread_pool::run_pending(size_t index) {
+    task_t task;
+    if (!pop(index, task)) {
+        return false;
+    }
+    --queued_;
+    task();
+    return true;
+}
+
+void thread_pool::work(size_t index) {
+    current_pool = this;
+    current_queue = index;
+    while (!stop_) {
+        if (!run_pending(index)) {
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            wake_.wait(lock, [this] { return stop_ || queued_ != 0; });
+        }
+    }
+}
+
+// Public methods
+
+thread_pool::thread_pool(unsigned threads) : queued_(0), stop_(false) {
+    for (unsigned i = 0; i <= threads; ++i) {
+        queues_.emplace_back(new task_queue);
+    }
+    try {
+        for (unsigned i = 0; i != threads; ++i) {
+            workers_.emplace_back(&thread_pool::work, this, i);
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        throw;
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+unsigned thread_pool::size() const {
+    return static_cast<unsigned>(workers_.size());
+}
+
+void thread_pool::spawn(task_group& group, task_t task) {
+    ++group.pending;
+    task_t wrapped = [&group, task]() {
+        try {
+            task();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(group.error_mutex);
+            if (!group.error) {
+                group.error = std::current_exception();
+            }
+        }
+        // The group may be destroyed as soon as the counter drops
+        --group.pending;
+    };
+    // queued_ is increased first, so it never underflows and a sleeping worker can't miss the task
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        ++queued_;
+    }
+    try {
+        task_queue& queue = *queues_[own_queue()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(wrapped));
+    } catch (...) {
+        --queued_;
+        --group.pending;
+        throw;
+    }
+    wake_.notify_one();
+}
+
+void thread_pool::wait(task_group& group) {
+    size_t index = own_queue();
+    while (group.pending != 0) {
+        if (!run_pending(index)) {
+            std::this_thread::yield();
+        }
+    }
+    if (group.error) {
+        std::exception_ptr error = group.error;
+        group.error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
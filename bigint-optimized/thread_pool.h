@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fork-join pool with work stealing : every worker owns a deque, takes its own
+// (most recently spawned) tasks from the back and steals the oldest tasks from
+// the front of the other deques. Threads waiting for a group run pending tasks
+// instead of blocking, so tasks may spawn and wait for subtasks.
+class thread_pool {
+ public:
+    using task_t = std::function<void()>;
+
+    // Tasks that are waited for together
+    struct task_group {
+        task_group() : pending(0)
+        {}
+
+     private:
+        friend class thread_pool;
+
+        std::atomic<size_t> pending;
+        std::mutex error_mutex;
+        std::exception_ptr error;
+    };
+
+    explicit thread_pool(unsigned threads);
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+
+    ~thread_pool();
+
+    unsigned size() const;
+
+    void spawn(task_group& group, task_t task);
+
+    // Runs pending tasks until all tasks of the group are finished, then
+    // rethrows the first exception thrown by them
+    void wait(task_group& group);
+
+ private:
+    struct task_queue {
+        std::mutex mutex;
+        std::deque<task_t> tasks;
+    };
+
+    // One queue per worker, the last one is for the threads outside the pool
+    std::vector<std::unique_ptr<task_queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> queued_;
+    std::atomic<bool> stop_;
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+
+    size_t own_queue() const;
+    bool pop(size_t index, task_t& task);
+    bool run_pending(size_t index);
+    void work(size_t index);
+};
@@ -9,6 +9,12 @@
 #include <functional>
 #include <vector>
 
+// Helpful functions
+
+namespace {
+    __extension__ typedef unsigned __int128 uint128_t;
+}
+
 
 // Private Methods
 
@@ -173,6 +179,70 @@ bool big_integer::smaller(big_integer const& lng1, big_integer const& lng2, uint
     return lng1.val_[i + shift] < lng2.val_[i];
 }
 
+int big_integer::cmp_builtin(uint64_t magnitude, bool negative) const {
+    if (sign_ != negative) {
+        return sign_ ? -1 : 1;
+    }
+    int res = 1;
+    if (val_.size() <= 2) {
+        uint64_t low = val_.size() == 2 ? static_cast<uint64_t>(val_[1]) << 32 | val_[0] : val_[0];
+        res = (low > magnitude) - (low < magnitude);
+    }
+    return sign_ ? -res : res;
+}
+
+void big_integer::add_builtin(uint64_t magnitude, bool negative) {
+    if (magnitude == 0) {
+        return;
+    }
+    if (is_zero()) {
+        sign_ = negative;
+    }
+    size_t n = std::max(val_.size(), static_cast<size_t>(2));
+    val_.resize(n);
+    // Only the two lowest limbs take the operand, the rest just propagate the carry
+    if (sign_ == negative) {
+        uint64_t carry = 0;
+        for (size_t i = 0; i != n && (i < 2 || carry != 0); ++i) {
+            carry += static_cast<uint64_t>(val_[i]) + (i < 2 ? static_cast<uint32_t>(magnitude >> (32 * i)) : 0);
+            val_[i] = static_cast<uint32_t>(carry);
+            carry >>= 32;
+        }
+        if (carry != 0) {
+            val_.push_back(static_cast<uint32_t>(carry));
+        }
+    } else if (n > 2 || (static_cast<uint64_t>(val_[1]) << 32 | val_[0]) >= magnitude) {
+        uint64_t borrow = 0;
+        for (size_t i = 0; i != n && (i < 2 || borrow != 0); ++i) {
+            uint64_t sub = (i < 2 ? static_cast<uint32_t>(magnitude >> (32 * i)) : 0) + borrow;
+            borrow = val_[i] < sub;
+            val_[i] = static_cast<uint32_t>(val_[i] - sub);
+        }
+    } else {
+        // |*this| < magnitude, the result takes the sign of the operand
+        magnitude -= static_cast<uint64_t>(val_[1]) << 32 | val_[0];
+        val_[0] = static_cast<uint32_t>(magnitude);
+        val_[1] = static_cast<uint32_t>(magnitude >> 32);
+        sign_ = negative;
+    }
+    clear_back();
+}
+
+void big_integer::mul_builtin(uint64_t magnitude, bool negative) {
+    size_t n = val_.size();
+    val_.resize(n + 2);
+    uint128_t carry = 0;
+    for (size_t i = 0; i != n; ++i) {
+        carry += static_cast<uint128_t>(val_[i]) * magnitude;
+        val_[i] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+    val_[n] = static_cast<uint32_t>(carry);
+    val_[n + 1] = static_cast<uint32_t>(carry >> 32);
+    sign_ ^= negative;
+    clear_back();
+}
+
 void big_integer::into_two_complement() {
     if (sign_) {
         std::for_each(val_.begin(), val_.end(), [](uint32_t& el) { el = ~el;});
@@ -532,3 +602,14 @@ std::string to_string(big_integer const& a) {
 std::ostream& operator<<(std::ostream& s, big_integer const& a) {
     return s << to_string(a);
 }
+
+size_t std::hash<big_integer>::operator()(big_integer const& a) const {
+    // Numbers are normalized, so equal values have equal limbs
+    uint64_t hash = 0xcbf29ce484222325;
+    for (uint32_t limb : a.val_) {
+        hash = (hash ^ limb) * 0x9e3779b97f4a7c15;
+        hash ^= hash >> 29;
+    }
+    hash ^= hash >> 32;
+    return static_cast<size_t>(hash) ^ (a.sign_ ? ~static_cast<size_t>(0) : 0);
+}
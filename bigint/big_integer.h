@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <vector>
 #include <functional>
+#include <type_traits>
 
 
 
@@ -65,6 +66,23 @@ class big_integer {
 
     void into_two_complement();
 
+    // Methods for builtin integer operands, the value is (negative ? -1 : 1) * magnitude :
+
+    template <typename T, typename R>
+    using if_builtin = typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+                                               sizeof(T) <= sizeof(uint64_t), R>::type;
+
+    template <typename T>
+    static uint64_t magnitude(T value) {
+        return value < 0 ? -static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    }
+
+    int cmp_builtin(uint64_t magnitude, bool negative) const;
+    // (*this)' = *this + value
+    void add_builtin(uint64_t magnitude, bool negative);
+    // (*this)' = *this * value
+    void mul_builtin(uint64_t magnitude, bool negative);
+
     // (*this)' = bit_op(*this, rhs)
     void apply_bit_op(big_integer const & rhs, std::function<uint32_t(uint32_t, uint32_t)> const& bit_op);
 
@@ -89,6 +107,25 @@ public:
     big_integer& operator|=(big_integer const& rhs);
     big_integer& operator^=(big_integer const& rhs);
 
+    // Integer operands up to 64 bits are applied to the limbs directly, without a temporary big_integer
+    template <typename T>
+    if_builtin<T, big_integer&> operator+=(T rhs) {
+        add_builtin(magnitude(rhs), rhs < 0);
+        return *this;
+    }
+
+    template <typename T>
+    if_builtin<T, big_integer&> operator-=(T rhs) {
+        add_builtin(magnitude(rhs), !(rhs < 0));
+        return *this;
+    }
+
+    template <typename T>
+    if_builtin<T, big_integer&> operator*=(T rhs) {
+        mul_builtin(magnitude(rhs), rhs < 0);
+        return *this;
+    }
+
     big_integer& operator<<=(int rhs);
     big_integer& operator>>=(int rhs);
 
@@ -109,7 +146,99 @@ public:
     friend bool operator<=(big_integer const& a, big_integer const& b);
     friend bool operator>=(big_integer const& a, big_integer const& b);
 
+    template <typename T>
+    friend if_builtin<T, big_integer> operator+(big_integer a, T b) {
+        return a += b;
+    }
+
+    template <typename T>
+    friend if_builtin<T, big_integer> operator+(T a, big_integer b) {
+        return b += a;
+    }
+
+    template <typename T>
+    friend if_builtin<T, big_integer> operator-(big_integer a, T b) {
+        return a -= b;
+    }
+
+    template <typename T>
+    friend if_builtin<T, big_integer> operator-(T a, big_integer b) {
+        return -(b -= a);
+    }
+
+    template <typename T>
+    friend if_builtin<T, big_integer> operator*(big_integer a, T b) {
+        return a *= b;
+    }
+
+    template <typename T>
+    friend if_builtin<T, big_integer> operator*(T a, big_integer b) {
+        return b *= a;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator==(big_integer const& a, T b) {
+        return a.cmp_builtin(magnitude(b), b < 0) == 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator!=(big_integer const& a, T b) {
+        return a.cmp_builtin(magnitude(b), b < 0) != 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator<(big_integer const& a, T b) {
+        return a.cmp_builtin(magnitude(b), b < 0) < 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator>(big_integer const& a, T b) {
+        return a.cmp_builtin(magnitude(b), b < 0) > 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator<=(big_integer const& a, T b) {
+        return a.cmp_builtin(magnitude(b), b < 0) <= 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator>=(big_integer const& a, T b) {
+        return a.cmp_builtin(magnitude(b), b < 0) >= 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator==(T a, big_integer const& b) {
+        return b.cmp_builtin(magnitude(a), a < 0) == 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator!=(T a, big_integer const& b) {
+        return b.cmp_builtin(magnitude(a), a < 0) != 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator<(T a, big_integer const& b) {
+        return b.cmp_builtin(magnitude(a), a < 0) > 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator>(T a, big_integer const& b) {
+        return b.cmp_builtin(magnitude(a), a < 0) < 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator<=(T a, big_integer const& b) {
+        return b.cmp_builtin(magnitude(a), a < 0) >= 0;
+    }
+
+    template <typename T>
+    friend if_builtin<T, bool> operator>=(T a, big_integer const& b) {
+        return b.cmp_builtin(magnitude(a), a < 0) <= 0;
+    }
+
     friend std::string to_string(big_integer const& a);
+
+    friend struct std::hash<big_integer>;
 };
 
 big_integer operator+(big_integer a, big_integer const& b);
@@ -126,3 +255,10 @@ big_integer operator<<(big_integer a, int b);
 big_integer operator>>(big_integer a, int b);
 
 std::ostream& operator<<(std::ostream& s, big_integer const& a);
+
+namespace std {
+    template <>
+    struct hash<big_integer> {
+        size_t operator()(big_integer const& a) const;
+    };
+}
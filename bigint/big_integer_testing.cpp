@@ -4,6 +4,7 @@
 #include <random>
 #include <vector>
 #include <utility>
+#include <unordered_set>
 #include <gtest/gtest.h>
 
 #include "big_integer.h"
@@ -815,3 +816,73 @@ TEST(correctness_twos_complement, all_ones) {
 
   EXPECT_EQ(to_string(gmp_ans), to_string(your_ans));
 }
+
+TEST(correctness, hash) {
+  std::hash<big_integer> h;
+  big_integer a = rand_big(50);
+  EXPECT_EQ(h(a), h(big_integer(to_string(a))));
+  EXPECT_EQ(h(big_integer(0)), h(-big_integer(0)));
+  EXPECT_NE(h(a), h(-a));
+
+  std::unordered_set<big_integer> set;
+  for (int i = -1000; i != 1000; ++i) {
+    set.insert(big_integer(i) * a);
+  }
+  EXPECT_EQ(2000u, set.size());
+  EXPECT_EQ(1u, set.count(a * -1000));
+  EXPECT_EQ(0u, set.count(a * 1000));
+}
+
+TEST(correctness, builtin_operands) {
+  big_integer a("18446744073709551616");
+  EXPECT_TRUE(a > UINT64_MAX);
+  EXPECT_TRUE(-a < INT64_MIN);
+  EXPECT_TRUE(a - 1 == UINT64_MAX);
+  EXPECT_TRUE(UINT64_MAX == a - 1u);
+  EXPECT_TRUE(0 == big_integer(0));
+  EXPECT_TRUE(big_integer(-5) < 0);
+  EXPECT_TRUE(-5 < big_integer(-4));
+  EXPECT_TRUE(big_integer(-5) != -4l);
+  EXPECT_TRUE(7u >= big_integer(7));
+  EXPECT_TRUE(big_integer(0) > INT64_MIN);
+
+  EXPECT_EQ(big_integer(3), big_integer(-4) + 7);
+  EXPECT_EQ(big_integer(-11), big_integer(-4) - 7ull);
+  EXPECT_EQ(big_integer(-3), 7 - big_integer(10));
+  EXPECT_EQ(big_integer(-3), -7 + big_integer(4));
+  EXPECT_EQ(big_integer(0), big_integer(-4) + 4);
+  EXPECT_EQ(-a, big_integer(-1) - UINT64_MAX);
+  EXPECT_EQ(big_integer(-1), INT64_MAX - a / 2);
+  EXPECT_EQ(big_integer(1), a - UINT64_MAX);
+  EXPECT_EQ(a + a / 2 - 1, INT64_MIN * big_integer(-2) + INT64_MAX);
+  EXPECT_EQ(big_integer(0), big_integer(0) * -3);
+  EXPECT_EQ(big_integer(-6), -3 * big_integer(2));
+
+  big_integer b = a;
+  b *= UINT64_MAX;
+  EXPECT_EQ(a * a - a, b);
+  b += b;
+  b -= INT64_MIN;
+  EXPECT_EQ(a * a + a * a - a - a + a / 2, b);
+}
+
+TEST(correctness_random, builtin_operands) {
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer a = rand_big(itn % 5);
+    if (rand() % 2) {
+      a = -a;
+    }
+    int64_t x = static_cast<int64_t>(static_cast<uint64_t>(rand()) << 33 ^ static_cast<uint64_t>(rand()) << (rand() % 33));
+    if (rand() % 2) {
+      x = -x;
+    }
+    big_integer y(std::to_string(x));
+    EXPECT_EQ(a + y, a + x);
+    EXPECT_EQ(a - y, a - x);
+    EXPECT_EQ(y - a, x - a);
+    EXPECT_EQ(a * y, a * x);
+    EXPECT_EQ(a < y, a < x);
+    EXPECT_EQ(a == y, a == x);
+    EXPECT_EQ(y >= a, x >= a);
+  }
+}
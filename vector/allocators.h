@@ -0,0 +1,577 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <sys/mman.h>
+
+// Memory resources for request-scoped containers and the allocators that give
+// vector / small_vector access to them. Neither resource is thread-safe.
+// Containers only hold a pointer to the resource, so it must outlive them.
+
+// Monotonic arena : allocation bumps a pointer, deallocation is a no-op except for
+// the most recent block, which is given back, so short-lived buffers on top of
+// the arena don't waste it. Everything is freed at once by release() or the destructor.
+struct arena
+{
+    constexpr static size_t DEFAULT_CHUNK_SIZE = 1 << 16;
+    // Smaller chunk sizes are raised to it, so chunks can still grow
+    constexpr static size_t MIN_CHUNK_SIZE = 256;
+
+    explicit arena(size_t chunk_size = DEFAULT_CHUNK_SIZE);
+    // The first allocations are served from buffer, which isn't freed by the arena
+    arena(void* buffer, size_t size, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+    arena(arena const&) = delete;
+    arena& operator=(arena const&) = delete;
+    ~arena();
+
+    void* allocate(size_t size, size_t alignment);
+    void deallocate(void* p, size_t size);
+    // Frees all chunks, memory handed out before becomes invalid
+    void release();
+
+    // Bytes handed out since the last release
+    size_t used() const;
+
+private:
+    struct chunk
+    {
+        chunk* next;
+    };
+
+    void add_chunk(size_t size, size_t alignment);
+
+    char* initial_begin_;
+    char* initial_end_;
+    char* current_;
+    char* end_;
+    chunk* chunks_;
+    size_t chunk_size_;
+    size_t next_chunk_size_;
+    size_t used_;
+};
+
+// Pool of power-of-two blocks from 16 bytes to MAX_BLOCK_SIZE with a free list per size.
+// Blocks are carved from large chunks and reused after deallocation, bigger requests
+// go to operator new. Blocks are aligned to alignof(std::max_align_t).
+struct pool
+{
+    constexpr static size_t MIN_BLOCK_SIZE = 16;
+    constexpr static size_t MAX_BLOCK_SIZE = 1 << 16;
+    constexpr static size_t CHUNK_SIZE = 1 << 18;
+
+    pool();
+    pool(pool const&) = delete;
+    pool& operator=(pool const&) = delete;
+    ~pool();
+
+    void* allocate(size_t size);
+    void deallocate(void* p, size_t size);
+
+private:
+    struct block
+    {
+        block* next;
+    };
+
+    constexpr static size_t CLASSES = 13; // 16 .. 1 << 16
+
+    static size_t size_class(size_t size);
+    void refill(size_t cls);
+
+    block* free_[CLASSES];
+    block* chunks_;
+    char* current_;
+    char* end_;
+};
+
+// malloc for small blocks, anonymous mmap from a threshold on. Both grow
+// without copying where the system allows : realloc may extend the block in place,
+// mremap moves the pages instead of their contents. Mapped blocks are unmapped
+// as soon as they are freed or shrunk, so the memory goes back to the system at once.
+namespace realloc_memory
+{
+    constexpr size_t MMAP_THRESHOLD = 1 << 20;
+    constexpr size_t HUGE_PAGE_SIZE = 1 << 21;
+}
+
+struct mapping_options
+{
+    // Blocks of threshold bytes and more are mapped
+    explicit mapping_options(size_t threshold = realloc_memory::MMAP_THRESHOLD, bool huge_pages = false,
+                             bool populate = false)
+            : threshold(threshold), huge_pages(huge_pages), populate(populate)
+    {}
+
+    size_t threshold;
+    // Mapped blocks are rounded up and aligned to HUGE_PAGE_SIZE and marked MADV_HUGEPAGE,
+    // so they are backed by transparent huge pages where the system allows
+    bool huge_pages;
+    // The pages are faulted in by mmap (MAP_POPULATE) instead of on the first touch
+    bool populate;
+};
+
+namespace realloc_memory
+{
+    void* allocate(size_t size, mapping_options const& options);
+    void deallocate(void* p, size_t size, mapping_options const& options);
+    void* reallocate(void* p, size_t old_size, size_t new_size, mapping_options const& options);
+}
+
+// Allocator with a reallocate extension : vector grows trivially copyable elements
+// through it instead of allocating, copying and freeing.
+// With huge pages and a threshold of a few MB it is the storage for large vectors.
+template <typename T>
+struct realloc_allocator
+{
+    typedef T value_type;
+
+    realloc_allocator() noexcept
+    {}
+
+    explicit realloc_allocator(mapping_options const& options) noexcept : options_(options)
+    {}
+
+    template <typename U>
+    realloc_allocator(realloc_allocator<U> const& other) noexcept : options_(other.options())
+    {}
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(realloc_memory::allocate(bytes(n), options_));
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        realloc_memory::deallocate(p, n * sizeof(T), options_);
+    }
+
+    // The contents of p are kept, p is invalidated unless it is returned.
+    // Throws std::bad_alloc and keeps p intact on failure.
+    T* reallocate(T* p, size_t old_n, size_t new_n)
+    {
+        return static_cast<T*>(realloc_memory::reallocate(p, old_n * sizeof(T), bytes(new_n), options_));
+    }
+
+    mapping_options const& options() const
+    {
+        return options_;
+    }
+
+private:
+    static size_t bytes(size_t n)
+    {
+        if (n > SIZE_MAX / sizeof(T))
+        {
+            throw std::bad_alloc();
+        }
+        return n * sizeof(T);
+    }
+
+    mapping_options options_;
+};
+
+// The memory of one allocator can be freed by the other if both map the same blocks
+template <typename T, typename U>
+bool operator==(realloc_allocator<T> const& a, realloc_allocator<U> const& b)
+{
+    return a.options().threshold == b.options().threshold && a.options().huge_pages == b.options().huge_pages;
+}
+
+template <typename T, typename U>
+bool operator!=(realloc_allocator<T> const& a, realloc_allocator<U> const& b)
+{
+    return !(a == b);
+}
+
+template <typename T>
+struct arena_allocator
+{
+    typedef T value_type;
+
+    explicit arena_allocator(arena& resource) noexcept : resource_(&resource)
+    {}
+
+    template <typename U>
+    arena_allocator(arena_allocator<U> const& other) noexcept : resource_(&other.resource())
+    {}
+
+    T* allocate(size_t n)
+    {
+        if (n > SIZE_MAX / sizeof(T))
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        resource_->deallocate(p, n * sizeof(T));
+    }
+
+    arena& resource() const
+    {
+        return *resource_;
+    }
+
+private:
+    arena* resource_;
+};
+
+template <typename T, typename U>
+bool operator==(arena_allocator<T> const& a, arena_allocator<U> const& b)
+{
+    return &a.resource() == &b.resource();
+}
+
+template <typename T, typename U>
+bool operator!=(arena_allocator<T> const& a, arena_allocator<U> const& b)
+{
+    return !(a == b);
+}
+
+template <typename T>
+struct pool_allocator
+{
+    static_assert(alignof(T) <= alignof(std::max_align_t), "pool blocks aren't over-aligned");
+
+    typedef T value_type;
+
+    explicit pool_allocator(pool& resource) noexcept : resource_(&resource)
+    {}
+
+    template <typename U>
+    pool_allocator(pool_allocator<U> const& other) noexcept : resource_(&other.resource())
+    {}
+
+    T* allocate(size_t n)
+    {
+        if (n > SIZE_MAX / sizeof(T))
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(resource_->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        resource_->deallocate(p, n * sizeof(T));
+    }
+
+    pool& resource() const
+    {
+        return *resource_;
+    }
+
+private:
+    pool* resource_;
+};
+
+template <typename T, typename U>
+bool operator==(pool_allocator<T> const& a, pool_allocator<U> const& b)
+{
+    return &a.resource() == &b.resource();
+}
+
+template <typename T, typename U>
+bool operator!=(pool_allocator<T> const& a, pool_allocator<U> const& b)
+{
+    return !(a == b);
+}
+
+// arena
+
+inline arena::arena(size_t chunk_size) : arena(nullptr, 0, chunk_size)
+{}
+
+inline arena::arena(void* buffer, size_t size, size_t chunk_size)
+        : initial_begin_(static_cast<char*>(buffer)), initial_end_(static_cast<char*>(buffer) + size),
+          current_(initial_begin_), end_(initial_end_), chunks_(nullptr),
+          chunk_size_(chunk_size < MIN_CHUNK_SIZE ? MIN_CHUNK_SIZE : chunk_size),
+          next_chunk_size_(chunk_size_), used_(0)
+{}
+
+inline arena::~arena()
+{
+    release();
+}
+
+inline void* arena::allocate(size_t size, size_t alignment)
+{
+    void* p = current_;
+    size_t space = end_ - current_;
+    if (current_ == nullptr || !std::align(alignment, size, p, space))
+    {
+        add_chunk(size, alignment);
+        p = current_;
+        space = end_ - current_;
+        std::align(alignment, size, p, space);
+    }
+    current_ = static_cast<char*>(p) + size;
+    used_ += size;
+    return p;
+}
+
+inline void arena::deallocate(void* p, size_t size)
+{
+    if (static_cast<char*>(p) + size == current_)
+    {
+        current_ = static_cast<char*>(p);
+        used_ -= size;
+    }
+}
+
+inline void arena::release()
+{
+    while (chunks_)
+    {
+        chunk* next = chunks_->next;
+        operator delete (chunks_);
+        chunks_ = next;
+    }
+    current_ = initial_begin_;
+    end_ = initial_end_;
+    next_chunk_size_ = chunk_size_;
+    used_ = 0;
+}
+
+inline size_t arena::used() const
+{
+    return used_;
+}
+
+inline void arena::add_chunk(size_t size, size_t alignment)
+{
+    // Chunks grow geometrically, so a long-lived arena makes O(log) allocations
+    size_t header = sizeof(chunk) + alignment;
+    size_t chunk_size = next_chunk_size_;
+    if (chunk_size < header || size > chunk_size - header)
+    {
+        chunk_size = size + header;
+    }
+    chunk* c = static_cast<chunk*>(operator new (chunk_size));
+    c->next = chunks_;
+    chunks_ = c;
+    current_ = reinterpret_cast<char*>(c + 1);
+    end_ = reinterpret_cast<char*>(c) + chunk_size;
+    next_chunk_size_ *= 2;
+}
+
+// pool
+
+inline pool::pool() : free_(), chunks_(nullptr), current_(nullptr), end_(nullptr)
+{}
+
+inline pool::~pool()
+{
+    while (chunks_)
+    {
+        block* next = chunks_->next;
+        operator delete (chunks_);
+        chunks_ = next;
+    }
+}
+
+inline size_t pool::size_class(size_t size)
+{
+    size_t cls = 0;
+    for (size_t block_size = MIN_BLOCK_SIZE; block_size < size; block_size *= 2)
+    {
+        ++cls;
+    }
+    return cls;
+}
+
+inline void* pool::allocate(size_t size)
+{
+    if (size > MAX_BLOCK_SIZE)
+    {
+        return operator new (size);
+    }
+    size_t cls = size_class(size);
+    if (!free_[cls])
+    {
+        refill(cls);
+    }
+    block* b = free_[cls];
+    free_[cls] = b->next;
+    return b;
+}
+
+inline void pool::deallocate(void* p, size_t size)
+{
+    if (size > MAX_BLOCK_SIZE)
+    {
+        operator delete (p);
+        return;
+    }
+    size_t cls = size_class(size);
+    block* b = static_cast<block*>(p);
+    b->next = free_[cls];
+    free_[cls] = b;
+}
+
+inline void pool::refill(size_t cls)
+{
+    size_t block_size = MIN_BLOCK_SIZE << cls;
+    if (static_cast<size_t>(end_ - current_) < block_size)
+    {
+        // The rest of the chunk goes to the smaller free lists
+        for (size_t c = cls; c-- != 0;)
+        {
+            size_t small_size = MIN_BLOCK_SIZE << c;
+            if (static_cast<size_t>(end_ - current_) >= small_size)
+            {
+                block* b = reinterpret_cast<block*>(current_);
+                b->next = free_[c];
+                free_[c] = b;
+                current_ += small_size;
+            }
+        }
+        char* c = static_cast<char*>(operator new (CHUNK_SIZE + alignof(std::max_align_t)));
+        block* header = reinterpret_cast<block*>(c);
+        header->next = chunks_;
+        chunks_ = header;
+        current_ = c + alignof(std::max_align_t);
+        end_ = current_ + CHUNK_SIZE;
+    }
+    block* b = reinterpret_cast<block*>(current_);
+    b->next = nullptr;
+    free_[cls] = b;
+    current_ += block_size;
+}
+
+// realloc_memory
+
+namespace realloc_memory
+{
+    inline bool is_mapped(size_t size, mapping_options const& options)
+    {
+        return size >= options.threshold && size != 0;
+    }
+
+    inline size_t mapping_size(size_t size, mapping_options const& options)
+    {
+        return options.huge_pages ? (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE : size;
+    }
+
+    inline void populate(void* p, size_t size)
+    {
+#ifdef MADV_POPULATE_WRITE
+        if (madvise(p, size, MADV_POPULATE_WRITE) == 0)
+        {
+            return;
+        }
+#endif
+        // Older kernels : a write per page faults it in
+        for (size_t i = 0; i < size; i += 4096)
+        {
+            static_cast<char volatile*>(p)[i] = 0;
+        }
+    }
+
+    inline void* map(size_t size, mapping_options const& options)
+    {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | (options.populate ? MAP_POPULATE : 0);
+        if (!options.huge_pages)
+        {
+            void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (p == MAP_FAILED)
+            {
+                throw std::bad_alloc();
+            }
+            return p;
+        }
+        // mmap only aligns to 4 KB : one huge page more is mapped and the ends are cut off.
+        // The pages are populated after madvise, so they come as huge pages.
+        size_t length = mapping_size(size, options);
+        void* p = mmap(nullptr, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+        char* begin = static_cast<char*>(p);
+        char* aligned = reinterpret_cast<char*>(
+                (reinterpret_cast<uintptr_t>(begin) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+        if (aligned != begin)
+        {
+            munmap(begin, aligned - begin);
+        }
+        munmap(aligned + length, begin + HUGE_PAGE_SIZE - aligned);
+#ifdef MADV_HUGEPAGE
+        madvise(aligned, length, MADV_HUGEPAGE);
+#endif
+        if (options.populate)
+        {
+            populate(aligned, length);
+        }
+        return aligned;
+    }
+}
+
+inline void* realloc_memory::allocate(size_t size, mapping_options const& options)
+{
+    if (is_mapped(size, options))
+    {
+        return map(size, options);
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+inline void realloc_memory::deallocate(void* p, size_t size, mapping_options const& options)
+{
+    if (is_mapped(size, options))
+    {
+        munmap(p, mapping_size(size, options));
+    }
+    else
+    {
+        std::free(p);
+    }
+}
+
+inline void* realloc_memory::reallocate(void* p, size_t old_size, size_t new_size, mapping_options const& options)
+{
+    bool old_mapped = is_mapped(old_size, options);
+    bool new_mapped = is_mapped(new_size, options);
+    if (old_mapped && new_mapped)
+    {
+        // Shrinking unmaps the tail at once. A moved block may lose the huge page alignment
+        // of its start, the rest is still backed by huge pages.
+        size_t old_length = mapping_size(old_size, options);
+        size_t new_length = mapping_size(new_size, options);
+        void* res = mremap(p, old_length, new_length, MREMAP_MAYMOVE);
+        if (res == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+        if (options.populate && new_length > old_length)
+        {
+            populate(static_cast<char*>(res) + old_length, new_length - old_length);
+        }
+        return res;
+    }
+    if (!old_mapped && !new_mapped)
+    {
+        void* res = std::realloc(p, new_size ? new_size : 1);
+        if (!res)
+        {
+            throw std::bad_alloc();
+        }
+        return res;
+    }
+    void* res = allocate(new_size, options);
+    std::memcpy(res, p, std::min(old_size, new_size));
+    deallocate(p, old_size, options);
+    return res;
+}
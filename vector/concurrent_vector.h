@@ -0,0 +1,321 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "element_utils.h"
+
+// Append-only vector for many producer threads. The elements live in segments of
+// FIRST_SEGMENT_SIZE, 2 * FIRST_SEGMENT_SIZE, 4 * FIRST_SEGMENT_SIZE ... elements
+// that are never moved or freed until clear() or destruction, so references stay valid.
+// push_back / emplace_back claim an index with one fetch_add and construct the element
+// in place : they are lock-free, the only other shared write is the installation of
+// a new segment, where a thread that loses the race frees its own one.
+// An element may be read by index once its push_back has returned and the reader is
+// synchronized with the writer (e.g. by joining the thread). size() counts claimed
+// indices, elements under construction included.
+// The allocator is called from the producer threads, so it must be thread-safe.
+// clear(), reserve and destruction must not run concurrently with other calls.
+template <typename T, typename Allocator = std::allocator<T>>
+struct concurrent_vector : private Allocator
+{
+    typedef Allocator allocator_type;
+
+    constexpr static size_t FIRST_SEGMENT_BITS = 5;
+    constexpr static size_t FIRST_SEGMENT_SIZE = size_t(1) << FIRST_SEGMENT_BITS;
+
+    concurrent_vector();                    // O(1) nothrow
+    explicit concurrent_vector(Allocator const&); // O(1) nothrow
+    concurrent_vector(concurrent_vector const&) = delete;
+    concurrent_vector& operator=(concurrent_vector const&) = delete;
+
+    ~concurrent_vector();                   // O(N) nothrow
+
+    Allocator get_allocator() const;        // O(1) nothrow
+
+    T& operator[](size_t i);                // O(1) nothrow
+    T const& operator[](size_t i) const;    // O(1) nothrow
+
+    size_t size() const;                    // O(1) nothrow
+    bool empty() const;                     // O(1) nothrow
+
+    // Returns the index of the new element
+    size_t push_back(T const&);             // O(1) lock-free strong
+    size_t push_back(T&&);                  // O(1) lock-free strong
+    template <typename... Args>
+    T& emplace_back(Args&&... args);        // O(1) lock-free strong
+
+    // Allocates the segments for the first n elements
+    void reserve(size_t n);                 // O(log n) strong
+    // Destroys the elements and keeps the segments
+    void clear();                           // O(N) nothrow
+
+private:
+    constexpr static size_t SEGMENTS = sizeof(size_t) * 8 - FIRST_SEGMENT_BITS;
+
+    typedef std::allocator_traits<Allocator> alloc_traits;
+
+    // Index whose element failed to construct, skipped on destruction
+    struct failed_slot
+    {
+        size_t index;
+        failed_slot* next;
+    };
+
+    Allocator& alloc();
+    static size_t segment_of(size_t i);
+    static size_t segment_begin(size_t segment);
+    static size_t segment_size(size_t segment);
+    T* get_segment(size_t segment);
+    T* slot(size_t i) const;
+    template <typename... Args>
+    size_t emplace(Args&&... args);
+    void mark_failed(size_t i);
+    bool is_failed(size_t i) const;
+    void destroy_elements();
+
+private:
+    std::atomic<size_t> size_;
+    std::atomic<T*> segments_[SEGMENTS];
+    std::atomic<failed_slot*> failed_;
+};
+
+// Private methods
+
+template <typename T, typename Allocator>
+Allocator& concurrent_vector<T, Allocator>::alloc()
+{
+    return *this;
+}
+
+template <typename T, typename Allocator>
+size_t concurrent_vector<T, Allocator>::segment_of(size_t i)
+{
+    // Segment k holds indices [FIRST_SEGMENT_SIZE * (2^k - 1), FIRST_SEGMENT_SIZE * (2^(k + 1) - 1))
+    size_t shifted = (i >> FIRST_SEGMENT_BITS) + 1;
+    return sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(shifted);
+}
+
+template <typename T, typename Allocator>
+size_t concurrent_vector<T, Allocator>::segment_begin(size_t segment)
+{
+    return ((size_t(1) << segment) - 1) << FIRST_SEGMENT_BITS;
+}
+
+template <typename T, typename Allocator>
+size_t concurrent_vector<T, Allocator>::segment_size(size_t segment)
+{
+    return size_t(1) << (segment + FIRST_SEGMENT_BITS);
+}
+
+template <typename T, typename Allocator>
+T* concurrent_vector<T, Allocator>::get_segment(size_t segment)
+{
+    T* data = segments_[segment].load(std::memory_order_acquire);
+    if (data)
+    {
+        return data;
+    }
+    T* fresh = alloc_traits::allocate(alloc(), segment_size(segment));
+    if (segments_[segment].compare_exchange_strong(data, fresh, std::memory_order_acq_rel,
+                                                   std::memory_order_acquire))
+    {
+        return fresh;
+    }
+    // Another thread installed the segment first
+    alloc_traits::deallocate(alloc(), fresh, segment_size(segment));
+    return data;
+}
+
+template <typename T, typename Allocator>
+T* concurrent_vector<T, Allocator>::slot(size_t i) const
+{
+    size_t segment = segment_of(i);
+    return segments_[segment].load(std::memory_order_acquire) + (i - segment_begin(segment));
+}
+
+template <typename T, typename Allocator>
+template <typename... Args>
+size_t concurrent_vector<T, Allocator>::emplace(Args&&... args)
+{
+    size_t i = size_.fetch_add(1, std::memory_order_relaxed);
+    size_t segment = segment_of(i);
+    try
+    {
+        T* data = get_segment(segment);
+        new (data + (i - segment_begin(segment))) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        // The index is taken for good, so the slot is remembered as empty
+        mark_failed(i);
+        throw;
+    }
+    return i;
+}
+
+template <typename T, typename Allocator>
+void concurrent_vector<T, Allocator>::mark_failed(size_t i)
+{
+    failed_slot* node = new (std::nothrow) failed_slot;
+    if (!node)
+    {
+        // Without the record the destructor would destroy a nonexistent element
+        std::terminate();
+    }
+    node->index = i;
+    node->next = failed_.load(std::memory_order_relaxed);
+    while (!failed_.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+    {}
+}
+
+template <typename T, typename Allocator>
+bool concurrent_vector<T, Allocator>::is_failed(size_t i) const
+{
+    for (failed_slot* node = failed_.load(std::memory_order_acquire); node; node = node->next)
+    {
+        if (node->index == i)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T, typename Allocator>
+void concurrent_vector<T, Allocator>::destroy_elements()
+{
+    size_t size = size_.load(std::memory_order_acquire);
+    bool failures = failed_.load(std::memory_order_acquire) != nullptr;
+    for (size_t segment = 0; segment != SEGMENTS && segment_begin(segment) < size; ++segment)
+    {
+        T* data = segments_[segment].load(std::memory_order_relaxed);
+        if (!data)
+        {
+            // Its allocation failed, every slot of it is recorded as failed
+            continue;
+        }
+        size_t count = std::min(segment_size(segment), size - segment_begin(segment));
+        if (!failures)
+        {
+            element_utils::destroy_all(data, count);
+            continue;
+        }
+        // Failures are rare, a linear lookup is enough
+        for (size_t j = count; j != 0; --j)
+        {
+            if (!is_failed(segment_begin(segment) + j - 1))
+            {
+                data[j - 1].~T();
+            }
+        }
+    }
+    failed_slot* node = failed_.exchange(nullptr, std::memory_order_acquire);
+    while (node)
+    {
+        failed_slot* next = node->next;
+        delete node;
+        node = next;
+    }
+    size_.store(0, std::memory_order_relaxed);
+}
+
+// Public methods
+
+template <typename T, typename Allocator>
+concurrent_vector<T, Allocator>::concurrent_vector() : concurrent_vector(Allocator())
+{}
+
+template <typename T, typename Allocator>
+concurrent_vector<T, Allocator>::concurrent_vector(Allocator const& alloc)
+        : Allocator(alloc), size_(0), failed_(nullptr)
+{
+    for (size_t segment = 0; segment != SEGMENTS; ++segment)
+    {
+        segments_[segment].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+template <typename T, typename Allocator>
+concurrent_vector<T, Allocator>::~concurrent_vector()
+{
+    destroy_elements();
+    for (size_t segment = 0; segment != SEGMENTS; ++segment)
+    {
+        T* data = segments_[segment].load(std::memory_order_relaxed);
+        if (data)
+        {
+            alloc_traits::deallocate(alloc(), data, segment_size(segment));
+        }
+    }
+}
+
+template <typename T, typename Allocator>
+Allocator concurrent_vector<T, Allocator>::get_allocator() const
+{
+    return *this;
+}
+
+template <typename T, typename Allocator>
+T& concurrent_vector<T, Allocator>::operator[](size_t i)
+{
+    return *slot(i);
+}
+
+template <typename T, typename Allocator>
+T const& concurrent_vector<T, Allocator>::operator[](size_t i) const
+{
+    return *slot(i);
+}
+
+template <typename T, typename Allocator>
+size_t concurrent_vector<T, Allocator>::size() const
+{
+    return size_.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Allocator>
+bool concurrent_vector<T, Allocator>::empty() const
+{
+    return size() == 0;
+}
+
+template <typename T, typename Allocator>
+size_t concurrent_vector<T, Allocator>::push_back(T const& val)
+{
+    return emplace(val);
+}
+
+template <typename T, typename Allocator>
+size_t concurrent_vector<T, Allocator>::push_back(T&& val)
+{
+    return emplace(std::move(val));
+}
+
+template <typename T, typename Allocator>
+template <typename... Args>
+T& concurrent_vector<T, Allocator>::emplace_back(Args&&... args)
+{
+    return *slot(emplace(std::forward<Args>(args)...));
+}
+
+template <typename T, typename Allocator>
+void concurrent_vector<T, Allocator>::reserve(size_t n)
+{
+    for (size_t segment = 0; segment != SEGMENTS && segment_begin(segment) < n; ++segment)
+    {
+        get_segment(segment);
+    }
+}
+
+template <typename T, typename Allocator>
+void concurrent_vector<T, Allocator>::clear()
+{
+    destroy_elements();
+}
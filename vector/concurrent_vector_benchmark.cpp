@@ -0,0 +1,81 @@
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "vector.h"
+#include "concurrent_vector.h"
+
+// Threads push N ints in total into one container : concurrent_vector against
+// vector and std::vector behind a mutex. Prints millions of push_backs per second.
+
+namespace {
+    size_t const N = 1 << 24;
+    size_t const REPEATS = 3;
+
+    template <typename T>
+    void escape(T& value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    template <typename F>
+    double measure(size_t threads_count, F const& f) {
+        double best = 0;
+        for (size_t r = 0; r != REPEATS; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            f(threads_count);
+            std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+            if (r == 0 || time.count() < best) {
+                best = time.count();
+            }
+        }
+        return N / best / 1e6;
+    }
+
+    template <typename Push>
+    void run_threads(size_t threads_count, Push const& push) {
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t != threads_count; ++t) {
+            threads.emplace_back([&push, threads_count, t] {
+                for (size_t i = t; i < N; i += threads_count) {
+                    push(static_cast<int>(i));
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    template <typename V>
+    void locked(size_t threads_count) {
+        V v;
+        std::mutex m;
+        run_threads(threads_count, [&](int x) {
+            std::lock_guard<std::mutex> lock(m);
+            v.push_back(x);
+        });
+        escape(v);
+    }
+
+    void concurrent(size_t threads_count) {
+        concurrent_vector<int> v;
+        run_threads(threads_count, [&](int x) {
+            v.push_back(x);
+        });
+        escape(v);
+    }
+}
+
+int main() {
+    std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+    std::printf("threads  concurrent_vector  vector+mutex  std::vector+mutex  M push_back/s\n");
+    for (size_t threads_count : {1, 2, 4, 8}) {
+        std::printf("%7zu  %17.1f  %12.1f  %17.1f\n", threads_count,
+                    measure(threads_count, concurrent),
+                    measure(threads_count, locked<vector<int>>),
+                    measure(threads_count, locked<std::vector<int>>));
+    }
+    return 0;
+}
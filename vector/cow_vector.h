@@ -0,0 +1,671 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "element_utils.h"
+
+// vector whose copies share one reference-counted buffer, as number_storage does :
+// copying is O(1), the elements are copied on the first modification of a shared buffer.
+// Reading never detaches, so there is no non-const operator[] or begin() : elements are
+// changed in place through the span returned by unshare(), which checks the reference
+// count once instead of on every access.
+// The reference count is atomic, so copies of one vector can live in different threads.
+// A single cow_vector isn't thread-safe.
+// The buffer comes from Allocator rebound to raw blocks. Copies share the buffer only
+// if their allocators are equal, otherwise the elements are copied.
+template <typename T, typename Allocator = std::allocator<T>>
+struct cow_vector : private Allocator
+{
+    typedef T const* const_iterator;
+    typedef Allocator allocator_type;
+
+    // Writable view of the elements, valid until the vector is copied or modified
+    struct mutable_span
+    {
+        T* begin() const;
+        T* end() const;
+        T* data() const;
+        size_t size() const;
+        T& operator[](size_t i) const;
+
+    private:
+        friend struct cow_vector;
+
+        mutable_span(T* data, size_t size);
+
+        T* data_;
+        size_t size_;
+    };
+
+    cow_vector();                           // O(1) nothrow
+    explicit cow_vector(Allocator const&);  // O(1) nothrow
+    cow_vector(cow_vector const&);          // O(1) nothrow with equal allocators
+    cow_vector(cow_vector const&, Allocator const&); // O(1) nothrow with equal allocators, O(N) strong otherwise
+    cow_vector& operator=(cow_vector const& other); // O(1) nothrow with equal allocators
+    cow_vector(cow_vector&&) noexcept;      // O(1) nothrow
+    cow_vector& operator=(cow_vector&& other)
+            noexcept(std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value);
+
+    ~cow_vector();                          // O(N) nothrow, O(1) if the buffer is shared
+
+    Allocator get_allocator() const;        // O(1) nothrow
+
+    T const& operator[](size_t i) const;    // O(1) nothrow
+
+    T const* data() const;                  // O(1) nothrow
+    size_t size() const;                    // O(1) nothrow
+
+    T const& front() const;                 // O(1) nothrow
+    T const& back() const;                  // O(1) nothrow
+
+    // Makes the buffer unique and returns its elements for writing
+    mutable_span unshare();                 // O(N) strong if shared, O(1) nothrow otherwise
+    // True if other copies refer to the same buffer
+    bool is_shared() const;                 // O(1) nothrow
+    bool shares_data(cow_vector const& other) const; // O(1) nothrow
+
+    void push_back(T const&);               // O(1)* strong
+    void push_back(T&&);                    // O(1)* strong
+    template <typename... Args>
+    T& emplace_back(Args&&... args);        // O(1)* strong
+    void pop_back();                        // O(1) nothrow if unique, O(N) strong otherwise
+
+    bool empty() const;                     // O(1) nothrow
+
+    size_t capacity() const;                // O(1) nothrow
+    void reserve(size_t);                   // O(N) strong
+    // A shared buffer is left as is
+    void shrink_to_fit();                   // O(N) strong
+
+    void clear();                           // O(N) nothrow, O(1) if the buffer is shared
+
+    void swap(cow_vector&);                 // O(1) nothrow
+
+    const_iterator begin() const;           // O(1) nothrow
+    const_iterator end() const;             // O(1) nothrow
+
+    // A shared buffer is copied first, positions refer to it
+    template <typename... Args>
+    const_iterator emplace(const_iterator pos, Args&&... args); // O(N) weak
+    const_iterator insert(const_iterator pos, T const&); // O(N) weak
+    const_iterator insert(const_iterator pos, T&&); // O(N) weak
+    const_iterator insert(const_iterator pos, size_t n, T const&); // O(N + n) weak
+    template <typename InputIt, typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    const_iterator insert(const_iterator pos, InputIt first, InputIt last); // O(N + n) weak
+    const_iterator insert(const_iterator pos, std::initializer_list<T>); // O(N + n) weak
+
+    const_iterator erase(const_iterator pos); // O(N) weak
+    const_iterator erase(const_iterator first, const_iterator last); // O(N) weak
+
+private:
+    struct header
+    {
+        std::atomic<size_t> ref_counter;
+        size_t capacity;
+    };
+
+    // The header and the elements are allocated as blocks of ALIGNMENT bytes,
+    // the elements start HEADER_SIZE bytes after the header
+    constexpr static size_t ALIGNMENT = alignof(header) < alignof(T) ? alignof(T) : alignof(header);
+    constexpr static size_t HEADER_SIZE = (sizeof(header) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    typedef typename std::aligned_storage<ALIGNMENT, ALIGNMENT>::type block_t;
+    typedef std::allocator_traits<Allocator> alloc_traits;
+    typedef typename alloc_traits::template rebind_alloc<block_t> block_allocator;
+    typedef std::allocator_traits<block_allocator> block_traits;
+
+    Allocator& alloc();
+    Allocator const& alloc() const;
+    header* get_header() const;
+    static size_t blocks(size_t capacity);
+    T* allocate(size_t capacity);
+    void deallocate(T* data);
+    void swap_fields(cow_vector& other);
+    bool is_unique() const;
+    void detach(size_t capacity);
+    template <typename InputIt>
+    void insert_range(size_t pos, InputIt first, InputIt last, std::input_iterator_tag);
+    template <typename ForwardIt>
+    void insert_range(size_t pos, ForwardIt first, ForwardIt last, std::forward_iterator_tag);
+    size_t get_increased_capacity(size_t required) const;
+    void release();
+
+private:
+    T* data_;
+    size_t size_;
+};
+
+// mutable_span
+
+template <typename T, typename Allocator>
+cow_vector<T, Allocator>::mutable_span::mutable_span(T* data, size_t size) : data_(data), size_(size)
+{}
+
+template <typename T, typename Allocator>
+T* cow_vector<T, Allocator>::mutable_span::begin() const
+{
+    return data_;
+}
+
+template <typename T, typename Allocator>
+T* cow_vector<T, Allocator>::mutable_span::end() const
+{
+    return data_ + size_;
+}
+
+template <typename T, typename Allocator>
+T* cow_vector<T, Allocator>::mutable_span::data() const
+{
+    return data_;
+}
+
+template <typename T, typename Allocator>
+size_t cow_vector<T, Allocator>::mutable_span::size() const
+{
+    return size_;
+}
+
+template <typename T, typename Allocator>
+T& cow_vector<T, Allocator>::mutable_span::operator[](size_t i) const
+{
+    return data_[i];
+}
+
+// Private methods
+
+template <typename T, typename Allocator>
+Allocator& cow_vector<T, Allocator>::alloc()
+{
+    return *this;
+}
+
+template <typename T, typename Allocator>
+Allocator const& cow_vector<T, Allocator>::alloc() const
+{
+    return *this;
+}
+
+template <typename T, typename Allocator>
+typename cow_vector<T, Allocator>::header* cow_vector<T, Allocator>::get_header() const
+{
+    return reinterpret_cast<header*>(reinterpret_cast<char*>(data_) - HEADER_SIZE);
+}
+
+template <typename T, typename Allocator>
+size_t cow_vector<T, Allocator>::blocks(size_t capacity)
+{
+    if (capacity > (SIZE_MAX - HEADER_SIZE - ALIGNMENT) / sizeof(T))
+    {
+        throw std::bad_alloc();
+    }
+    return (HEADER_SIZE + capacity * sizeof(T) + ALIGNMENT - 1) / ALIGNMENT;
+}
+
+template <typename T, typename Allocator>
+T* cow_vector<T, Allocator>::allocate(size_t capacity)
+{
+    block_allocator blocks_alloc(alloc());
+    block_t* p = block_traits::allocate(blocks_alloc, blocks(capacity));
+    header* h = new (p) header;
+    h->ref_counter.store(1, std::memory_order_relaxed);
+    h->capacity = capacity;
+    return reinterpret_cast<T*>(reinterpret_cast<char*>(p) + HEADER_SIZE);
+}
+
+template <typename T, typename Allocator>
+void cow_vector<T, Allocator>::deallocate(T* data)
+{
+    header* h = reinterpret_cast<header*>(reinterpret_cast<char*>(data) - HEADER_SIZE);
+    size_t n = blocks(h->capacity);
+    h->~header();
+    block_allocator blocks_alloc(alloc());
+    block_traits::deallocate(blocks_alloc, reinterpret_cast<block_t*>(h), n);
+}
+
+template <typename T, typename Allocator>
+void cow_vector<T, Allocator>::swap_fields(cow_vector<T, Allocator>& other)
+{
+    using std::swap;
+    swap(data_, other.data_);
+    swap(size_, other.size_);
+}
+
+template <typename T, typename Allocator>
+bool cow_vector<T, Allocator>::is_unique() const
+{
+    // acquire pairs with the release in release() : writes of the former owners
+    // happen before ours
+    return !data_ || get_header()->ref_counter.load(std::memory_order_acquire) == 1;
+}
+
+template <typename T, typename Allocator>
+void cow_vector<T, Allocator>::detach(size_t capacity)
+{
+    // Moves the elements to a new unique buffer of the given capacity, a shared buffer
+    // is copied and stays intact for the other owners
+    T* data = allocate(capacity);
+    try
+    {
+        if (is_unique())
+        {
+            element_utils::relocate_all(data, data_, size_);
+        }
+        else
+        {
+            element_utils::copy_construct_all(data, static_cast<T const*>(data_), size_);
+        }
+    }
+    catch (...)
+    {
+        deallocate(data);
+        throw;
+    }
+    size_t size = size_;
+    release();
+    data_ = data;
+    size_ = size;
+}
+
+template <typename T, typename Allocator>
+template <typename InputIt>
+void cow_vector<T, Allocator>::insert_range(size_t pos, InputIt first, InputIt last, std::input_iterator_tag)
+{
+    // The length is unknown, so the elements are appended and rotated into place
+    size_t old_size = size_;
+    for (; first != last; ++first)
+    {
+        emplace_back(*first);
+    }
+    std::rotate(data_ + pos, data_ + old_size, data_ + size_);
+}
+
+template <typename T, typename Allocator>
+template <typename ForwardIt>
+void cow_vector<T, Allocator>::insert_range(size_t pos, ForwardIt first, ForwardIt last, std::forward_iterator_tag)
+{
+    size_t n = std::distance(first, last);
+    if (n == 0)
+    {
+        return;
+    }
+    if (size_ + n > capacity())
+    {
+        detach(get_increased_capacity(size_ + n));
+    }
+    else if (!is_unique())
+    {
+        detach(capacity());
+    }
+    element_utils::insert_in_place(data_, size_, pos, first, last, n);
+}
+
+template <typename T, typename Allocator>
+size_t cow_vector<T, Allocator>::get_increased_capacity(size_t required) const
+{
+    return std::max(capacity() ? 2 * capacity() : 1, required);
+}
+
+template <typename T, typename Allocator>
+void cow_vector<T, Allocator>::release()
+{
+    if (data_ && get_header()->ref_counter.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        element_utils::destroy_all(data_, size_);
+        deallocate(data_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+// Public methods
+
+template <typename T, typename Allocator>
+cow_vector<T, Allocator>::cow_vector() : cow_vector(Allocator())
+{}
+
+template <typename T, typename Allocator>
+cow_vector<T, Allocator>::cow_vector(Allocator const& alloc) : Allocator(alloc), data_(nullptr), size_(0)
+{}
+
+template <typename T, typename Allocator>
+cow_vector<T, Allocator>::cow_vector(cow_vector<T, Allocator> const& other)
+        : cow_vector(other, alloc_traits::select_on_container_copy_construction(other.alloc()))
+{}
+
+template <typename T, typename Allocator>
+cow_vector<T, Allocator>::cow_vector(cow_vector<T, Allocator> const& other, Allocator const& alloc)
+        : cow_vector(alloc)
+{
+    if (!other.data_)
+    {
+        return;
+    }
+    if (this->alloc() == other.alloc())
+    {
+        other.get_header()->ref_counter.fetch_add(1, std::memory_order_relaxed);
+        data_ = other.data_;
+        size_ = other.size_;
+        return;
+    }
+    if (other.size_ > 0)
+    {
+        T* data = allocate(other.size_);
+        try
+        {
+            element_utils::copy_construct_all(data, other.data(), other.size_);
+        }
+        catch (...)
+        {
+            deallocate(data);
+            throw;
+        }
+        data_ = data;
+        size_ = other.size_;
+    }
+}
+
+template <typename T, typename Allocator>
+cow_vector<T, Allocator>& cow_vector<T, Allocator>::operator=(cow_vector<T, Allocator> const& other)
+{
+    if (this != &other)
+    {
+        bool const propagate = alloc_traits::propagate_on_container_copy_assignment::value;
+        cow_vector copy(other, propagate ? other.alloc() : alloc());
+        swap_fields(copy);
+        if (propagate)
+        {
+            using std::swap;
+            swap(alloc(), copy.alloc());
+        }
+    }
+    return *this;
+}
+
+template <typename T, typename Allocator>
+cow_vector<T, Allocator>::cow_vector(cow_vector<T, Allocator>&& other) noexcept
+        : Allocator(std::move(other.alloc())), data_(nullptr), size_(0)
+{
+    swap_fields(other);
+}
+
+template <typename T, typename Allocator>
+cow_vector<T, Allocator>& cow_vector<T, Allocator>::operator=(cow_vector<T, Allocator>&& other)
+        noexcept(std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value)
+{
+    bool const propagate = alloc_traits::propagate_on_container_move_assignment::value;
+    if (propagate || alloc() == other.alloc())
+    {
+        cow_vector copy = std::move(other);
+        swap_fields(copy);
+        if (propagate)
+        {
+            using std::swap;
+            swap(alloc(), copy.alloc());
+        }
+    }
+    else
+    {
+        // The buffer can't change hands, so the elements are copied into memory of our allocator
+        cow_vector copy(other, alloc());
+        swap_fields(copy);
+    }
+    return *this;
+}
+
+template <typename T, typename Allocator>
+cow_vector<T, Allocator>::~cow_vector()
+{
+    release();
+}
+
+template <typename T, typename Allocator>
+Allocator cow_vector<T, Allocator>::get_allocator() const
+{
+    return alloc();
+}
+
+template <typename T, typename Allocator>
+T const& cow_vector<T, Allocator>::operator[](size_t i) const
+{
+    return data_[i];
+}
+
+template <typename T, typename Allocator>
+T const* cow_vector<T, Allocator>::data() const
+{
+    return data_;
+}
+
+template <typename T, typename Allocator>
+size_t cow_vector<T, Allocator>::size() const
+{
+    return size_;
+}
+
+template <typename T, typename Allocator>
+T const& cow_vector<T, Allocator>::front() const
+{
+    return *data_;
+}
+
+template <typename T, typename Allocator>
+T const& cow_vector<T, Allocator>::back() const
+{
+    return data_[size_ - 1];
+}
+
+template <typename T, typename Allocator>
+typename cow_vector<T, Allocator>::mutable_span cow_vector<T, Allocator>::unshare()
+{
+    if (!is_unique())
+    {
+        detach(capacity());
+    }
+    return mutable_span(data_, size_);
+}
+
+template <typename T, typename Allocator>
+bool cow_vector<T, Allocator>::is_shared() const
+{
+    return !is_unique();
+}
+
+template <typename T, typename Allocator>
+bool cow_vector<T, Allocator>::shares_data(cow_vector<T, Allocator> const& other) const
+{
+    return data_ && data_ == other.data_;
+}
+
+template <typename T, typename Allocator>
+void cow_vector<T, Allocator>::push_back(T const& val)
+{
+    emplace_back(val);
+}
+
+template <typename T, typename Allocator>
+void cow_vector<T, Allocator>::push_back(T&& val)
+{
+    emplace_back(std::move(val));
+}
+
+template <typename T, typename Allocator>
+template <typename... Args>
+T& cow_vector<T, Allocator>::emplace_back(Args&&... args)
+{
+    if (size_ < capacity() && is_unique())
+    {
+        new (data_ + size_) T(std::forward<Args>(args)...);
+    }
+    else
+    {
+        // args may refer to the old elements
+        T val(std::forward<Args>(args)...);
+        detach(size_ < capacity() ? capacity() : get_increased_capacity(size_ + 1));
+        new (data_ + size_) T(std::move(val));
+    }
+    ++size_;
+    return data_[size_ - 1];
+}
+
+template <typename T, typename Allocator>
+void cow_vector<T, Allocator>::pop_back()
+{
+    if (!is_unique())
+    {
+        detach(capacity());
+    }
+    data_[--size_].~T();
+}
+
+template <typename T, typename Allocator>
+bool cow_vector<T, Allocator>::empty() const
+{
+    return size_ == 0;
+}
+
+template <typename T, typename Allocator>
+size_t cow_vector<T, Allocator>::capacity() const
+{
+    return data_ ? get_header()->capacity : 0;
+}
+
+template <typename T, typename Allocator>
+void cow_vector<T, Allocator>::reserve(size_t new_capacity)
+{
+    if (new_capacity > capacity())
+    {
+        detach(new_capacity);
+    }
+}
+
+template <typename T, typename Allocator>
+void cow_vector<T, Allocator>::shrink_to_fit()
+{
+    if (capacity() > size_ && is_unique())
+    {
+        if (size_ == 0)
+        {
+            release();
+        }
+        else
+        {
+            detach(size_);
+        }
+    }
+}
+
+template <typename T, typename Allocator>
+void cow_vector<T, Allocator>::clear()
+{
+    if (is_unique())
+    {
+        element_utils::destroy_all(data_, size_);
+        size_ = 0;
+    }
+    else
+    {
+        release();
+    }
+}
+
+template <typename T, typename Allocator>
+void cow_vector<T, Allocator>::swap(cow_vector<T, Allocator>& other)
+{
+    if (alloc_traits::propagate_on_container_swap::value)
+    {
+        using std::swap;
+        swap(alloc(), other.alloc());
+    }
+    swap_fields(other);
+}
+
+template <typename T, typename Allocator>
+typename cow_vector<T, Allocator>::const_iterator cow_vector<T, Allocator>::begin() const
+{
+    return data_;
+}
+
+template <typename T, typename Allocator>
+typename cow_vector<T, Allocator>::const_iterator cow_vector<T, Allocator>::end() const
+{
+    return data_ + size_;
+}
+
+template <typename T, typename Allocator>
+template <typename... Args>
+typename cow_vector<T, Allocator>::const_iterator cow_vector<T, Allocator>::emplace(const_iterator pos, Args&&... args)
+{
+    size_t at = pos - begin();
+    emplace_back(std::forward<Args>(args)...);
+    element_utils::move_back_to(data_, size_, at);
+    return begin() + at;
+}
+
+template <typename T, typename Allocator>
+typename cow_vector<T, Allocator>::const_iterator cow_vector<T, Allocator>::insert(const_iterator pos, T const& val)
+{
+    return emplace(pos, val);
+}
+
+template <typename T, typename Allocator>
+typename cow_vector<T, Allocator>::const_iterator cow_vector<T, Allocator>::insert(const_iterator pos, T&& val)
+{
+    return emplace(pos, std::move(val));
+}
+
+template <typename T, typename Allocator>
+typename cow_vector<T, Allocator>::const_iterator cow_vector<T, Allocator>::insert(const_iterator pos, size_t n,
+                                                                                   T const& val)
+{
+    size_t at = pos - begin();
+    // val may be an element of this vector that is about to be moved
+    T copy(val);
+    typedef element_utils::repeat_iterator<T> repeat_iterator;
+    insert_range(at, repeat_iterator(copy, 0), repeat_iterator(copy, n), std::forward_iterator_tag());
+    return begin() + at;
+}
+
+template <typename T, typename Allocator>
+template <typename InputIt, typename>
+typename cow_vector<T, Allocator>::const_iterator cow_vector<T, Allocator>::insert(const_iterator pos, InputIt first,
+                                                                                   InputIt last)
+{
+    size_t at = pos - begin();
+    insert_range(at, first, last, typename std::iterator_traits<InputIt>::iterator_category());
+    return begin() + at;
+}
+
+template <typename T, typename Allocator>
+typename cow_vector<T, Allocator>::const_iterator cow_vector<T, Allocator>::insert(const_iterator pos,
+                                                                                   std::initializer_list<T> list)
+{
+    return insert(pos, list.begin(), list.end());
+}
+
+template <typename T, typename Allocator>
+typename cow_vector<T, Allocator>::const_iterator cow_vector<T, Allocator>::erase(const_iterator pos)
+{
+    return erase(pos, pos + 1);
+}
+
+template <typename T, typename Allocator>
+typename cow_vector<T, Allocator>::const_iterator cow_vector<T, Allocator>::erase(const_iterator first,
+                                                                                  const_iterator last)
+{
+    size_t shift = first - begin();
+    size_t end = last - begin();
+    if (first != last && !is_unique())
+    {
+        detach(capacity());
+    }
+    element_utils::erase_range(data_, size_, shift, end);
+    return begin() + shift;
+}
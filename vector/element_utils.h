@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Algorithms on raw element buffers shared by vector and small_vector.
+// Trivially copyable elements are copied and moved around with memcpy / memmove,
+// trivially destructible ones aren't destroyed at all.
+namespace element_utils
+{
+    template <typename T>
+    using trivially_copyable = typename std::is_trivially_copyable<T>::type;
+
+    template <typename T>
+    using trivially_destructible = typename std::is_trivially_destructible<T>::type;
+
+    template <typename T>
+    void destroy_all(T*, size_t, std::true_type)
+    {}
+
+    template <typename T>
+    void destroy_all(T* data, size_t i, std::false_type)
+    {
+        for (; i != 0; --i)
+        {
+            data[i - 1].~T();
+        }
+    }
+
+    template <typename T>
+    void destroy_all(T* data, size_t i)
+    {
+        destroy_all(data, i, trivially_destructible<T>());
+    }
+
+    template <typename T>
+    void copy_construct_all(T* dst, T const* src, size_t size, std::true_type)
+    {
+        if (size != 0)
+        {
+            std::memcpy(dst, src, sizeof(T) * size);
+        }
+    }
+
+    template <typename T>
+    void copy_construct_all(T* dst, T const* src, size_t size, std::false_type)
+    {
+        size_t i = 0;
+        try
+        {
+            for (; i != size; ++i)
+            {
+                new (dst + i) T(src[i]);
+            }
+        }
+        catch (...)
+        {
+            destroy_all(dst, i);
+            throw;
+        }
+    }
+
+    template <typename T>
+    void copy_construct_all(T* dst, T const* src, size_t size)
+    {
+        copy_construct_all(dst, src, size, trivially_copyable<T>());
+    }
+
+    template <typename T>
+    void relocate_all(T* dst, T* src, size_t size, std::true_type)
+    {
+        copy_construct_all(dst, src, size, std::true_type());
+    }
+
+    template <typename T>
+    void relocate_all(T* dst, T* src, size_t size, std::false_type)
+    {
+        // Elements are moved only if it can't throw, otherwise they are copied
+        // and src stays intact on failure
+        size_t i = 0;
+        try
+        {
+            for (; i != size; ++i)
+            {
+                new (dst + i) T(std::move_if_noexcept(src[i]));
+            }
+        }
+        catch (...)
+        {
+            destroy_all(dst, i);
+            throw;
+        }
+    }
+
+    // Constructs dst from src, the caller destroys src afterwards
+    template <typename T>
+    void relocate_all(T* dst, T* src, size_t size)
+    {
+        relocate_all(dst, src, size, trivially_copyable<T>());
+    }
+
+    template <typename T>
+    void move_back_to(T* data, size_t size, size_t pos, std::true_type)
+    {
+        T last = data[size - 1];
+        std::memmove(data + pos + 1, data + pos, sizeof(T) * (size - 1 - pos));
+        data[pos] = last;
+    }
+
+    template <typename T>
+    void move_back_to(T* data, size_t size, size_t pos, std::false_type)
+    {
+        if (pos + 1 != size)
+        {
+            T last(std::move(data[size - 1]));
+            std::move_backward(data + pos, data + size - 1, data + size);
+            data[pos] = std::move(last);
+        }
+    }
+
+    // Moves the last element to pos, shifting [pos, size - 1) to the right
+    template <typename T>
+    void move_back_to(T* data, size_t size, size_t pos)
+    {
+        move_back_to(data, size, pos, trivially_copyable<T>());
+    }
+
+    template <typename T>
+    void erase_range(T* data, size_t& size, size_t first, size_t last, std::true_type)
+    {
+        if (first != last)
+        {
+            std::memmove(data + first, data + last, sizeof(T) * (size - last));
+            size -= last - first;
+        }
+    }
+
+    template <typename T>
+    void erase_range(T* data, size_t& size, size_t first, size_t last, std::false_type)
+    {
+        size_t dist = last - first;
+        std::move(data + last, data + size, data + first);
+        destroy_all(data + size - dist, dist);
+        size -= dist;
+    }
+
+    template <typename T>
+    void erase_range(T* data, size_t& size, size_t first, size_t last)
+    {
+        erase_range(data, size, first, last, trivially_copyable<T>());
+    }
+
+    template <typename T, typename ForwardIt>
+    void insert_in_place(T* data, size_t& size, size_t pos, ForwardIt first, ForwardIt last, size_t n,
+                         std::true_type)
+    {
+        std::memmove(data + pos + n, data + pos, sizeof(T) * (size - pos));
+        try
+        {
+            std::uninitialized_copy(first, last, data + pos);
+        }
+        catch (...)
+        {
+            std::memmove(data + pos, data + pos + n, sizeof(T) * (size - pos));
+            throw;
+        }
+        size += n;
+    }
+
+    template <typename T, typename ForwardIt>
+    void insert_in_place(T* data, size_t& size, size_t pos, ForwardIt first, ForwardIt last, size_t n,
+                         std::false_type)
+    {
+        // The tail is shifted by n : the part that lands past the end is move-constructed,
+        // the rest is move-assigned, then the new elements are assigned or constructed
+        // in the freed slots
+        T* end = data + size;
+        size_t tail = size - pos;
+        if (n <= tail)
+        {
+            std::uninitialized_copy(std::make_move_iterator(end - n), std::make_move_iterator(end), end);
+            size += n;
+            std::move_backward(data + pos, end - n, end);
+            std::copy(first, last, data + pos);
+        }
+        else
+        {
+            ForwardIt mid = first;
+            std::advance(mid, tail);
+            std::uninitialized_copy(mid, last, end);
+            size += n - tail;
+            std::uninitialized_copy(std::make_move_iterator(data + pos), std::make_move_iterator(end),
+                                    data + pos + n);
+            size += tail;
+            std::copy(first, mid, data + pos);
+        }
+    }
+
+    // Inserts n elements of [first, last) at pos, capacity must be at least size + n.
+    // size is kept up to date, so the buffer stays valid if an element throws.
+    template <typename T, typename ForwardIt>
+    void insert_in_place(T* data, size_t& size, size_t pos, ForwardIt first, ForwardIt last, size_t n)
+    {
+        insert_in_place(data, size, pos, first, last, n, trivially_copyable<T>());
+    }
+
+    // The same value n times, for insert(pos, n, value)
+    template <typename T>
+    struct repeat_iterator
+    {
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef T const* pointer;
+        typedef T const& reference;
+
+        repeat_iterator(T const& val, size_t i) : val_(&val), i_(i)
+        {}
+
+        T const& operator*() const
+        {
+            return *val_;
+        }
+
+        T const* operator->() const
+        {
+            return val_;
+        }
+
+        repeat_iterator& operator++()
+        {
+            ++i_;
+            return *this;
+        }
+
+        repeat_iterator operator++(int)
+        {
+            repeat_iterator res = *this;
+            ++i_;
+            return res;
+        }
+
+        friend bool operator==(repeat_iterator const& a, repeat_iterator const& b)
+        {
+            return a.i_ == b.i_;
+        }
+
+        friend bool operator!=(repeat_iterator const& a, repeat_iterator const& b)
+        {
+            return a.i_ != b.i_;
+        }
+
+    private:
+        T const* val_;
+        size_t i_;
+    };
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Growth policies for vector : next_capacity returns the capacity to allocate when
+// capacity is exhausted and at least required elements must fit.
+
+// 2x, the default
+struct doubling_growth
+{
+    static size_t next_capacity(size_t capacity, size_t required, size_t)
+    {
+        return std::max(capacity ? 2 * capacity : 1, required);
+    }
+};
+
+// 1.5x : a freed buffer can be reused after a few growths, at the cost of more copies
+struct one_and_half_growth
+{
+    static size_t next_capacity(size_t capacity, size_t required, size_t)
+    {
+        return std::max(capacity + std::max(capacity / 2, static_cast<size_t>(1)), required);
+    }
+};
+
+// 1.5x with the byte size rounded up to a malloc size class, so the slack the allocator
+// would waste anyway becomes capacity : four classes per power of two up to 4 KB,
+// whole pages above
+struct size_class_growth
+{
+    static size_t next_capacity(size_t capacity, size_t required, size_t element_size)
+    {
+        size_t bytes = round_up(one_and_half_growth::next_capacity(capacity, required, element_size) * element_size);
+        return bytes / element_size;
+    }
+
+    static size_t round_up(size_t bytes)
+    {
+        size_t const PAGE_SIZE = 4096;
+        size_t const MIN_CLASS = 16;
+        if (bytes <= MIN_CLASS)
+        {
+            return MIN_CLASS;
+        }
+        if (bytes >= PAGE_SIZE)
+        {
+            return (bytes + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+        }
+        size_t power = MIN_CLASS;
+        while (2 * power < bytes)
+        {
+            power *= 2;
+        }
+        size_t step = std::max(power / 4, MIN_CLASS);
+        return (bytes + step - 1) / step * step;
+    }
+};
+
+// Allocators with a T* reallocate(T*, size_t old_n, size_t new_n) member can grow a buffer
+// without copying it : vector uses it for trivially copyable elements
+template <typename Allocator, typename = void>
+struct has_reallocate : std::false_type
+{};
+
+template <typename Allocator>
+struct has_reallocate<Allocator, decltype(void(std::declval<Allocator&>().reallocate(
+        std::declval<typename Allocator::value_type*>(), size_t(), size_t())))> : std::true_type
+{};
+
+template <typename Allocator>
+typename Allocator::value_type* reallocate(Allocator& alloc, typename Allocator::value_type* data,
+                                           size_t old_capacity, size_t new_capacity, std::true_type)
+{
+    return alloc.reallocate(data, old_capacity, new_capacity);
+}
+
+template <typename Allocator>
+typename Allocator::value_type* reallocate(Allocator& alloc, typename Allocator::value_type* data,
+                                           size_t old_capacity, size_t new_capacity, std::false_type)
+{
+    typedef std::allocator_traits<Allocator> alloc_traits;
+    typename Allocator::value_type* res = alloc_traits::allocate(alloc, new_capacity);
+    std::memcpy(res, data, sizeof(*data) * std::min(old_capacity, new_capacity));
+    alloc_traits::deallocate(alloc, data, old_capacity);
+    return res;
+}
+
+// Moves a buffer of trivially copyable elements to new_capacity, through
+// Allocator::reallocate if there is one
+template <typename Allocator>
+typename Allocator::value_type* reallocate(Allocator& alloc, typename Allocator::value_type* data,
+                                           size_t old_capacity, size_t new_capacity)
+{
+    return reallocate(alloc, data, old_capacity, new_capacity, has_reallocate<Allocator>());
+}
@@ -0,0 +1,85 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+#include "vector.h"
+#include "allocators.h"
+
+// Fills, scans and randomly reads a 512 MB vector<uint64_t> with each storage mode
+// and prints the time per element. The fill includes the page faults of the first
+// touch unless the pages are populated by mmap, the random reads show the TLB misses.
+
+namespace {
+    size_t const N = size_t(1) << 26;
+    size_t const RANDOM_READS = size_t(1) << 24;
+    size_t const REPEATS = 3;
+
+    template <typename T>
+    void escape(T& value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    template <typename F>
+    double measure(F const& f, size_t count) {
+        double best = 0;
+        for (size_t r = 0; r != REPEATS; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+            if (r == 0 || time.count() < best) {
+                best = time.count();
+            }
+        }
+        return best / count;
+    }
+
+    template <typename Allocator>
+    void run(char const* name, Allocator const& alloc) {
+        typedef vector<uint64_t, Allocator> vector_t;
+        double fill = measure([&] {
+            vector_t v(alloc);
+            v.reserve(N);
+            for (size_t i = 0; i != N; ++i) {
+                v.push_back(i);
+            }
+            escape(v);
+        }, N);
+
+        vector_t v(alloc);
+        v.reserve(N);
+        for (size_t i = 0; i != N; ++i) {
+            v.push_back(i);
+        }
+        double sequential = measure([&] {
+            uint64_t sum = 0;
+            for (size_t i = 0; i != N; ++i) {
+                sum += v[i];
+            }
+            escape(sum);
+        }, N);
+        double random = measure([&] {
+            uint64_t sum = 0;
+            uint64_t x = 88172645463325252ull;
+            for (size_t i = 0; i != RANDOM_READS; ++i) {
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+                sum += v[x & (N - 1)];
+            }
+            escape(sum);
+        }, RANDOM_READS);
+        std::printf("%-22s %8.2f  %10.2f  %8.2f\n", name, fill, sequential, random);
+    }
+}
+
+int main() {
+    std::printf("%-22s %8s  %10s  %8s  ns/element\n", "512 MB", "fill", "sequential", "random");
+    size_t const threshold = size_t(1) << 20;
+    run("operator new", std::allocator<uint64_t>());
+    run("mmap", realloc_allocator<uint64_t>(mapping_options(threshold)));
+    run("mmap, populate", realloc_allocator<uint64_t>(mapping_options(threshold, false, true)));
+    run("huge pages", realloc_allocator<uint64_t>(mapping_options(threshold, true)));
+    run("huge pages, populate", realloc_allocator<uint64_t>(mapping_options(threshold, true, true)));
+    return 0;
+}
@@ -1,10 +1,31 @@
 #include "vector.h"
+#include "small_vector.h"
+#include "cow_vector.h"
+#include "concurrent_vector.h"
+#include "allocators.h"
 #include "gtest/gtest.h"
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 template
 struct vector<int>;
 
+template
+struct small_vector<int, 4>;
+
+template
+struct cow_vector<int>;
+
+template
+struct concurrent_vector<int>;
+
 template<typename T>
 T const& as_const(T& obj) {
   return obj;
@@ -500,3 +521,976 @@ TEST(correctness, ctor_alloc) {
   EXPECT_EQ(1, b.capacity());
 }
 
+
+namespace {
+struct copy_counter {
+  static size_t copies;
+  static size_t moves;
+
+  copy_counter() = default;
+
+  copy_counter(copy_counter const&) {
+    ++copies;
+  }
+
+  copy_counter(copy_counter&&) noexcept {
+    ++moves;
+  }
+
+  copy_counter& operator=(copy_counter const&) {
+    ++copies;
+    return *this;
+  }
+
+  copy_counter& operator=(copy_counter&&) noexcept {
+    ++moves;
+    return *this;
+  }
+};
+
+size_t copy_counter::copies = 0;
+size_t copy_counter::moves = 0;
+
+// Copying is preferred to a move that may throw
+struct throwing_move {
+  static size_t copies;
+
+  throwing_move() = default;
+
+  throwing_move(throwing_move const&) {
+    ++copies;
+  }
+
+  throwing_move(throwing_move&&) noexcept(false) {}
+};
+
+size_t throwing_move::copies = 0;
+}
+
+TEST(correctness, move_ctor) {
+  size_t const N = 500;
+  {
+    vector<element<size_t> > a;
+    for (size_t i = 0; i != N; ++i) a.push_back(i);
+    element<size_t>* old_data = a.data();
+
+    vector<element<size_t> > b = std::move(a);
+    EXPECT_EQ(old_data, b.data());
+    EXPECT_EQ(N, b.size());
+    EXPECT_TRUE(a.empty());
+    for (size_t i = 0; i != N; ++i) EXPECT_EQ(i, b[i]);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, move_assignment) {
+  size_t const N = 500;
+  {
+    vector<element<size_t> > a;
+    for (size_t i = 0; i != N; ++i) a.push_back(2 * i + 1);
+
+    vector<element<size_t> > b;
+    b.push_back(42);
+
+    b = std::move(a);
+    EXPECT_EQ(N, b.size());
+    EXPECT_TRUE(a.empty());
+    for (size_t i = 0; i != N; ++i) EXPECT_EQ(2 * i + 1, b[i]);
+
+    b = std::move(b);
+    EXPECT_EQ(N, b.size());
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, push_back_move_only) {
+  size_t const N = 500;
+  vector<std::unique_ptr<size_t> > a;
+  for (size_t i = 0; i != N; ++i) a.push_back(std::unique_ptr<size_t>(new size_t(i)));
+  for (size_t i = 0; i != N; ++i) a.insert(a.begin() + i, std::unique_ptr<size_t>(new size_t(i)));
+  a.shrink_to_fit();
+
+  EXPECT_EQ(2 * N, a.size());
+  for (size_t i = 0; i != N; ++i) {
+    EXPECT_EQ(i, *a[i]);
+    EXPECT_EQ(i, *a[i + N]);
+  }
+}
+
+TEST(correctness, emplace) {
+  vector<std::string> a;
+  EXPECT_EQ("aaa", a.emplace_back(3, 'a'));
+  a.emplace_back("b");
+  a.emplace(a.begin() + 1, 2, 'c');
+  a.emplace(a.end(), a[0]);
+
+  EXPECT_EQ(4, a.size());
+  EXPECT_EQ("aaa", a[0]);
+  EXPECT_EQ("cc", a[1]);
+  EXPECT_EQ("b", a[2]);
+  EXPECT_EQ("aaa", a[3]);
+}
+
+TEST(correctness, emplace_back_from_self) {
+  size_t const N = 500;
+  vector<std::string> a;
+  a.emplace_back(100, 'x');
+  for (size_t i = 0; i != N; ++i) a.emplace_back(a[0]);
+  for (size_t i = 0; i != a.size(); ++i) EXPECT_EQ(std::string(100, 'x'), a[i]);
+}
+
+TEST(correctness, reallocation_moves) {
+  size_t const N = 500;
+  copy_counter::copies = 0;
+  vector<copy_counter> a;
+  for (size_t i = 0; i != N; ++i) a.emplace_back();
+  a.reserve(4 * N);
+  a.shrink_to_fit();
+  EXPECT_EQ(0, copy_counter::copies);
+
+  throwing_move::copies = 0;
+  vector<throwing_move> b;
+  for (size_t i = 0; i != N; ++i) b.emplace_back();
+  EXPECT_EQ(b.capacity() - 1, throwing_move::copies);
+}
+
+TEST(correctness, trivial_type) {
+  struct point {
+    int x, y;
+  };
+  bool test = std::is_trivially_copyable<point>::value;
+  EXPECT_TRUE(test);
+
+  size_t const N = 500;
+  vector<point> a;
+  for (size_t i = 0; i != N; ++i) a.push_back({static_cast<int>(i), -static_cast<int>(i)});
+  a.reserve(2 * N);
+  vector<point> b = a;
+  a.clear();
+  a.shrink_to_fit();
+  EXPECT_EQ(nullptr, a.data());
+
+  EXPECT_EQ(N, b.size());
+  for (size_t i = 0; i != N; ++i) {
+    EXPECT_EQ(i, b[i].x);
+    EXPECT_EQ(-static_cast<int>(i), b[i].y);
+  }
+}
+
+TEST(correctness_random, trivial_insert_erase) {
+  std::mt19937 rng(42);
+  vector<int> a;
+  std::vector<int> expected;
+  for (size_t i = 0; i != 2000; ++i) {
+    size_t pos = expected.empty() ? 0 : rng() % (expected.size() + 1);
+    if (rng() % 3 != 0) {
+      int val = static_cast<int>(rng());
+      a.insert(a.begin() + pos, val);
+      expected.insert(expected.begin() + pos, val);
+    } else if (pos != expected.size()) {
+      size_t len = rng() % (expected.size() - pos + 1);
+      a.erase(a.begin() + pos, a.begin() + pos + len);
+      expected.erase(expected.begin() + pos, expected.begin() + pos + len);
+    }
+    ASSERT_EQ(expected.size(), a.size());
+  }
+  for (size_t i = 0; i != expected.size(); ++i) EXPECT_EQ(expected[i], a[i]);
+}
+
+TEST(correctness, insert_count) {
+  {
+    vector<element<size_t> > a;
+    for (size_t i = 0; i != 10; ++i) a.push_back(i);
+    a.insert(a.begin() + 3, 5, 42);
+    a.reserve(100);
+    a.insert(a.begin() + 1, 2, a[0]);
+    a.insert(a.end() - 1, 20, a.back());
+    a.insert(a.begin(), 0, 7);
+
+    std::vector<size_t> expected = {0, 0, 0, 1, 2, 42, 42, 42, 42, 42, 3, 4, 5, 6, 7, 8};
+    expected.insert(expected.end(), 21, 9);
+    ASSERT_EQ(expected.size(), a.size());
+    for (size_t i = 0; i != expected.size(); ++i) EXPECT_EQ(expected[i], a[i]);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, insert_range) {
+  {
+    std::vector<element<size_t> > src;
+    for (size_t i = 0; i != 10; ++i) src.push_back(100 + i);
+
+    vector<element<size_t> > a;
+    a.insert(a.end(), src.begin(), src.begin() + 2);
+    size_t capacity = a.capacity();
+    a.insert(a.begin() + 1, src.begin(), src.end());
+    EXPECT_EQ(12, a.size());
+    EXPECT_NE(capacity, a.capacity());
+    a.insert(a.begin(), {element<size_t>(1), element<size_t>(2)});
+
+    std::vector<size_t> expected = {1, 2, 100, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 101};
+    ASSERT_EQ(expected.size(), a.size());
+    for (size_t i = 0; i != expected.size(); ++i) EXPECT_EQ(expected[i], a[i]);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, insert_input_range) {
+  std::istringstream s("4 5 6");
+  vector<int> a = {};
+  a.insert(a.end(), {1, 2, 3, 7});
+  a.insert(a.begin() + 3, std::istream_iterator<int>(s), std::istream_iterator<int>());
+  ASSERT_EQ(7, a.size());
+  for (size_t i = 0; i != 7; ++i) EXPECT_EQ(i + 1, a[i]);
+}
+
+TEST(correctness, insert_range_throw) {
+  {
+    vector<element<size_t> > a;
+    a.reserve(20);
+    for (size_t i = 0; i != 10; ++i) a.push_back(i);
+    std::vector<element<size_t> > src(5, 42);
+
+    element<size_t>::set_throw_countdown(3);
+    EXPECT_THROW(a.insert(a.begin() + 8, src.begin(), src.end()), std::runtime_error);
+    element<size_t>::set_throw_countdown(3);
+    EXPECT_THROW(a.insert(a.begin() + 2, src.begin(), src.end()), std::runtime_error);
+    element<size_t>::set_throw_countdown(0);
+
+    vector<element<size_t> > b;
+    for (size_t i = 0; i != 10; ++i) b.push_back(i);
+    b.shrink_to_fit();
+    element<size_t>::set_throw_countdown(12);
+    EXPECT_THROW(b.insert(b.begin() + 5, src.begin(), src.end()), std::runtime_error);
+    EXPECT_EQ(10, b.size());
+    for (size_t i = 0; i != 10; ++i) EXPECT_EQ(i, b[i]);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness_random, insert_erase) {
+  std::mt19937 rng(43);
+  {
+    vector<element<size_t> > a;
+    std::vector<size_t> expected;
+    for (size_t i = 0; i != 1000; ++i) {
+      size_t pos = expected.empty() ? 0 : rng() % (expected.size() + 1);
+      size_t len = rng() % 8;
+      switch (rng() % 3) {
+      case 0:
+        a.insert(a.begin() + pos, len, i);
+        expected.insert(expected.begin() + pos, len, i);
+        break;
+      case 1:
+        a.insert(a.begin() + pos, i);
+        expected.insert(expected.begin() + pos, i);
+        break;
+      default:
+        len = std::min(len, expected.size() - pos);
+        a.erase(a.begin() + pos, a.begin() + pos + len);
+        expected.erase(expected.begin() + pos, expected.begin() + pos + len);
+      }
+      ASSERT_EQ(expected.size(), a.size());
+    }
+    for (size_t i = 0; i != expected.size(); ++i) EXPECT_EQ(expected[i], a[i]);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, small_vector_inline) {
+  {
+    small_vector<element<size_t>, 4> a;
+    EXPECT_TRUE(a.is_inline());
+    EXPECT_EQ(4, a.capacity());
+    for (size_t i = 0; i != 4; ++i) a.push_back(i);
+    EXPECT_TRUE(a.is_inline());
+    EXPECT_TRUE(static_cast<void*>(a.data()) >= static_cast<void*>(&a) &&
+                static_cast<void*>(a.data()) < static_cast<void*>(&a + 1));
+
+    a.push_back(a[0]);
+    EXPECT_FALSE(a.is_inline());
+    EXPECT_EQ(8, a.capacity());
+    a.pop_back();
+    a.shrink_to_fit();
+    EXPECT_TRUE(a.is_inline());
+    EXPECT_EQ(4, a.capacity());
+    for (size_t i = 0; i != 4; ++i) EXPECT_EQ(i, a[i]);
+
+    a.reserve(100);
+    EXPECT_FALSE(a.is_inline());
+    EXPECT_EQ(100, a.capacity());
+    a.clear();
+    a.shrink_to_fit();
+    EXPECT_TRUE(a.is_inline());
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, small_vector_copy_move) {
+  {
+    small_vector<element<size_t>, 4> small;
+    small_vector<element<size_t>, 4> large;
+    for (size_t i = 0; i != 3; ++i) small.push_back(i);
+    for (size_t i = 0; i != 10; ++i) large.push_back(i);
+
+    small_vector<element<size_t>, 4> a = small;
+    small_vector<element<size_t>, 4> b = large;
+    EXPECT_TRUE(a.is_inline());
+    EXPECT_EQ(10, b.capacity());
+
+    small_vector<element<size_t>, 4> c = std::move(a);
+    small_vector<element<size_t>, 4> d = std::move(b);
+    EXPECT_TRUE(a.empty());
+    EXPECT_TRUE(b.empty());
+    EXPECT_TRUE(b.is_inline());
+    ASSERT_EQ(3, c.size());
+    ASSERT_EQ(10, d.size());
+    for (size_t i = 0; i != 3; ++i) EXPECT_EQ(i, c[i]);
+    for (size_t i = 0; i != 10; ++i) EXPECT_EQ(i, d[i]);
+
+    c = large;
+    d = small;
+    EXPECT_EQ(10, c.size());
+    EXPECT_TRUE(d.is_inline());
+    d = std::move(d);
+    EXPECT_EQ(3, d.size());
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, small_vector_swap) {
+  {
+    std::vector<size_t> sizes = {0, 2, 4, 5, 20};
+    for (size_t n : sizes) {
+      for (size_t m : sizes) {
+        small_vector<element<size_t>, 4> a, b;
+        for (size_t i = 0; i != n; ++i) a.push_back(i);
+        for (size_t i = 0; i != m; ++i) b.push_back(100 + i);
+        a.swap(b);
+        ASSERT_EQ(m, a.size());
+        ASSERT_EQ(n, b.size());
+        EXPECT_EQ(m <= 4, a.is_inline());
+        EXPECT_EQ(n <= 4, b.is_inline());
+        for (size_t i = 0; i != m; ++i) EXPECT_EQ(100 + i, a[i]);
+        for (size_t i = 0; i != n; ++i) EXPECT_EQ(i, b[i]);
+      }
+    }
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, small_vector_spill_throw) {
+  {
+    small_vector<element<size_t>, 4> a;
+    for (size_t i = 0; i != 4; ++i) a.push_back(i);
+    element<size_t>::set_throw_countdown(3);
+    EXPECT_THROW(a.push_back(42), std::runtime_error);
+    EXPECT_TRUE(a.is_inline());
+    ASSERT_EQ(4, a.size());
+    for (size_t i = 0; i != 4; ++i) EXPECT_EQ(i, a[i]);
+
+    element<size_t>::set_throw_countdown(2);
+    typedef small_vector<element<size_t>, 4> small_vector_t;
+    EXPECT_THROW(small_vector_t b(a), std::runtime_error);
+    element<size_t>::set_throw_countdown(0);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness_random, small_vector_insert_erase) {
+  std::mt19937 rng(44);
+  {
+    small_vector<element<size_t>, 8> a;
+    std::vector<size_t> expected;
+    for (size_t i = 0; i != 1000; ++i) {
+      size_t pos = expected.empty() ? 0 : rng() % (expected.size() + 1);
+      size_t len = rng() % 4;
+      switch (rng() % 4) {
+      case 0:
+        a.insert(a.begin() + pos, len, i);
+        expected.insert(expected.begin() + pos, len, i);
+        break;
+      case 1:
+        a.insert(a.begin() + pos, i);
+        expected.insert(expected.begin() + pos, i);
+        break;
+      case 2:
+        a.shrink_to_fit();
+        break;
+      default:
+        len = std::min(2 * len, expected.size() - pos);
+        a.erase(a.begin() + pos, a.begin() + pos + len);
+        expected.erase(expected.begin() + pos, expected.begin() + pos + len);
+      }
+      ASSERT_EQ(expected.size(), a.size());
+      EXPECT_EQ(a.capacity() == 8, a.is_inline());
+    }
+    for (size_t i = 0; i != expected.size(); ++i) EXPECT_EQ(expected[i], a[i]);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+namespace {
+// Stateful allocator that follows its container on copy, move and swap
+template <typename T>
+struct tagged_allocator {
+  typedef T value_type;
+  typedef std::true_type propagate_on_container_copy_assignment;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  explicit tagged_allocator(int tag) : tag(tag) {}
+
+  template <typename U>
+  tagged_allocator(tagged_allocator<U> const& other) : tag(other.tag) {}
+
+  T* allocate(size_t n) {
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* p, size_t n) {
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  friend bool operator==(tagged_allocator const& a, tagged_allocator const& b) {
+    return a.tag == b.tag;
+  }
+
+  friend bool operator!=(tagged_allocator const& a, tagged_allocator const& b) {
+    return a.tag != b.tag;
+  }
+
+  int tag;
+};
+}
+
+TEST(correctness, arena_allocator) {
+  arena memory;
+  {
+    typedef vector<element<size_t>, arena_allocator<element<size_t> > > vector_t;
+    vector_t a{arena_allocator<element<size_t> >(memory)};
+    for (size_t i = 0; i != 1000; ++i) a.push_back(i);
+    EXPECT_GE(memory.used(), 1000 * sizeof(element<size_t>));
+
+    vector_t b = a;
+    EXPECT_TRUE(b.get_allocator() == a.get_allocator());
+    for (size_t i = 0; i != 1000; ++i) EXPECT_EQ(i, b[i]);
+
+    arena other_memory;
+    vector_t c{arena_allocator<element<size_t> >(other_memory)};
+    c.push_back(42);
+    c = std::move(a);
+    EXPECT_EQ(&other_memory, &c.get_allocator().resource());
+    ASSERT_EQ(1000, c.size());
+    for (size_t i = 0; i != 1000; ++i) EXPECT_EQ(i, c[i]);
+
+    small_vector<element<size_t>, 4, arena_allocator<element<size_t> > > d{
+        arena_allocator<element<size_t> >(memory)};
+    for (size_t i = 0; i != 100; ++i) d.push_back(i);
+    EXPECT_FALSE(d.is_inline());
+    for (size_t i = 0; i != 100; ++i) EXPECT_EQ(i, d[i]);
+  }
+  element<size_t>::expect_no_instances();
+  memory.release();
+  EXPECT_EQ(0, memory.used());
+
+  // Chunk sizes below the chunk header still give blocks of the requested size
+  for (size_t chunk_size : {0, 1, 8}) {
+    arena tiny(chunk_size);
+    for (size_t i = 0; i != 10; ++i) {
+      void* p = tiny.allocate(64, 8);
+      std::memset(p, 0, 64);
+    }
+    void* p = tiny.allocate(32, 4096);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p) % 4096);
+    std::memset(p, 0, 32);
+  }
+  arena tiny(8);
+  vector<size_t, arena_allocator<size_t> > e{arena_allocator<size_t>(tiny)};
+  for (size_t i = 0; i != 1000; ++i) e.push_back(i);
+  for (size_t i = 0; i != 1000; ++i) EXPECT_EQ(i, e[i]);
+}
+
+TEST(correctness, arena_buffer) {
+  alignas(std::max_align_t) char buffer[256];
+  arena memory(buffer, sizeof(buffer));
+  vector<int, arena_allocator<int> > a{arena_allocator<int>(memory)};
+  a.reserve(16);
+  EXPECT_TRUE(static_cast<void*>(a.data()) == buffer);
+  for (int i = 0; i != 1000; ++i) a.push_back(i);
+  for (int i = 0; i != 1000; ++i) EXPECT_EQ(i, a[i]);
+
+  // The last block is given back
+  size_t used = memory.used();
+  int* p = arena_allocator<int>(memory).allocate(10);
+  arena_allocator<int>(memory).deallocate(p, 10);
+  EXPECT_EQ(used, memory.used());
+}
+
+TEST(correctness, pool_allocator) {
+  pool memory;
+  {
+    typedef vector<element<size_t>, pool_allocator<element<size_t> > > vector_t;
+    pool_allocator<element<size_t> > alloc(memory);
+    vector_t a(alloc);
+    for (size_t i = 0; i != 5000; ++i) a.push_back(i);
+    element<size_t>* old_data = a.data();
+    a.clear();
+    a.shrink_to_fit();
+
+    // Freed blocks are reused
+    vector_t b(alloc);
+    b.reserve(8192);
+    EXPECT_EQ(old_data, b.data());
+
+    std::vector<vector_t> many;
+    for (size_t i = 0; i != 100; ++i) {
+      many.push_back(vector_t(alloc));
+      for (size_t j = 0; j != i; ++j) many.back().push_back(j);
+    }
+    for (size_t i = 0; i != 100; ++i) {
+      ASSERT_EQ(i, many[i].size());
+      for (size_t j = 0; j != i; ++j) EXPECT_EQ(j, many[i][j]);
+    }
+
+    small_vector<element<size_t>, 2, pool_allocator<element<size_t> > > c(alloc);
+    for (size_t i = 0; i != 100; ++i) c.push_back(i);
+    c.erase(c.begin(), c.end() - 1);
+    c.shrink_to_fit();
+    EXPECT_TRUE(c.is_inline());
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, allocator_propagation) {
+  {
+    typedef vector<element<size_t>, tagged_allocator<element<size_t> > > vector_t;
+    vector_t a{tagged_allocator<element<size_t> >(1)};
+    vector_t b{tagged_allocator<element<size_t> >(2)};
+    a.push_back(1);
+    b.push_back(2);
+
+    a.swap(b);
+    EXPECT_EQ(2, a.get_allocator().tag);
+    EXPECT_EQ(1, b.get_allocator().tag);
+
+    vector_t c = a;
+    EXPECT_EQ(2, c.get_allocator().tag);
+    c = b;
+    EXPECT_EQ(1, c.get_allocator().tag);
+    c = std::move(a);
+    EXPECT_EQ(2, c.get_allocator().tag);
+    EXPECT_EQ(2, c[0]);
+
+    typedef small_vector<element<size_t>, 1, tagged_allocator<element<size_t> > > small_vector_t;
+    small_vector_t d{tagged_allocator<element<size_t> >(3)};
+    small_vector_t e{tagged_allocator<element<size_t> >(4)};
+    for (size_t i = 0; i != 10; ++i) d.push_back(i);
+    e = d;
+    EXPECT_EQ(3, e.get_allocator().tag);
+    e.push_back(10);
+    d.swap(e);
+    EXPECT_EQ(11, d.size());
+    e = std::move(d);
+    EXPECT_EQ(11, e.size());
+    EXPECT_EQ(3, e.get_allocator().tag);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, growth_policies) {
+  vector<int, std::allocator<int>, one_and_half_growth> a;
+  std::vector<size_t> capacities;
+  for (int i = 0; i != 20; ++i) {
+    a.push_back(i);
+    if (capacities.empty() || capacities.back() != a.capacity()) capacities.push_back(a.capacity());
+  }
+  EXPECT_EQ((std::vector<size_t>{1, 2, 3, 4, 6, 9, 13, 19, 28}), capacities);
+  for (int i = 0; i != 20; ++i) EXPECT_EQ(i, a[i]);
+
+  EXPECT_EQ(16, size_class_growth::round_up(1));
+  EXPECT_EQ(48, size_class_growth::round_up(33));
+  EXPECT_EQ(160, size_class_growth::round_up(129));
+  EXPECT_EQ(8192, size_class_growth::round_up(4097));
+
+  vector<element<size_t>, std::allocator<element<size_t> >, size_class_growth> b;
+  for (size_t i = 0; i != 1000; ++i) {
+    b.push_back(i);
+    EXPECT_EQ(size_class_growth::round_up(b.capacity() * sizeof(element<size_t>)),
+              b.capacity() * sizeof(element<size_t>));
+  }
+  b.insert(b.begin(), 500, 7);
+  EXPECT_EQ(1500, b.size());
+  EXPECT_EQ(7, b[499]);
+  EXPECT_EQ(0, b[500]);
+}
+
+TEST(correctness, realloc_allocator) {
+  static_assert(has_reallocate<realloc_allocator<int> >::value, "");
+  static_assert(!has_reallocate<std::allocator<int> >::value, "");
+
+  // Past the mmap threshold the buffer grows with mremap
+  size_t const n = 3 * realloc_memory::MMAP_THRESHOLD / sizeof(int);
+  vector<int, realloc_allocator<int> > a;
+  for (size_t i = 0; i != n; ++i) {
+    a.push_back(static_cast<int>(i));
+  }
+  a.push_back(a[0]);
+  a.insert(a.begin() + 1, 3, a[1]);
+  EXPECT_EQ(n + 4, a.size());
+  EXPECT_EQ(0, a[n + 3]);
+  EXPECT_EQ(1, a[3]);
+  EXPECT_EQ(1, a[4]);
+  EXPECT_EQ(2, a[5]);
+
+  a.erase(a.begin() + 100, a.end());
+  a.shrink_to_fit();
+  EXPECT_EQ(100, a.capacity());
+  a.reserve(n);
+  EXPECT_EQ(n, a.capacity());
+  for (size_t i = 4; i != 100; ++i) EXPECT_EQ(i - 3, a[i]);
+
+  vector<int, realloc_allocator<int> > b = a;
+  EXPECT_EQ(100, b.size());
+  EXPECT_EQ(a[99], b[99]);
+
+  // Elements that aren't trivially copyable are relocated one by one
+  {
+    vector<element<size_t>, realloc_allocator<element<size_t> > > c;
+    for (size_t i = 0; i != 100; ++i) c.push_back(i);
+    c.insert(c.begin(), 10, c[5]);
+    c.shrink_to_fit();
+    EXPECT_EQ(110, c.size());
+    EXPECT_EQ(5, c[0]);
+    EXPECT_EQ(99, c.back());
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, mapped_storage) {
+  size_t const threshold = 4 * realloc_memory::HUGE_PAGE_SIZE;
+  realloc_allocator<size_t> huge(mapping_options(threshold, true, true));
+  vector<size_t, realloc_allocator<size_t> > a(huge);
+  size_t const n = 3 * threshold / sizeof(size_t);
+  a.reserve(n);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(a.data()) % realloc_memory::HUGE_PAGE_SIZE);
+  for (size_t i = 0; i != 2 * n; ++i) a.push_back(i);
+  EXPECT_EQ(2 * n, a.capacity());
+
+  // Shrinking goes through mremap, then back to malloc below the threshold
+  a.erase(a.begin() + n / 2, a.end());
+  a.shrink_to_fit();
+  EXPECT_EQ(n / 2, a.capacity());
+  a.erase(a.begin() + 100, a.end());
+  a.shrink_to_fit();
+  EXPECT_EQ(100, a.capacity());
+  for (size_t i = 0; i != 100; ++i) EXPECT_EQ(i, a[i]);
+
+  // Blocks of one allocator can't be freed by the other
+  vector<size_t, realloc_allocator<size_t> > b;
+  EXPECT_NE(a.get_allocator(), b.get_allocator());
+  b = std::move(a);
+  EXPECT_EQ(100, b.size());
+  EXPECT_EQ(99, b[99]);
+}
+
+TEST(correctness, cow_vector_sharing) {
+  {
+    cow_vector<element<size_t> > a;
+    for (size_t i = 0; i != 10; ++i) a.push_back(i);
+    EXPECT_FALSE(a.is_shared());
+
+    size_t instances = element<size_t>::instances().size();
+    cow_vector<element<size_t> > b = a;
+    cow_vector<element<size_t> > c;
+    c = b;
+    EXPECT_EQ(instances, element<size_t>::instances().size());
+    EXPECT_TRUE(a.shares_data(b));
+    EXPECT_TRUE(a.shares_data(c));
+    EXPECT_TRUE(b.is_shared());
+    EXPECT_EQ(9, as_const(c)[9]);
+
+    cow_vector<element<size_t> >::mutable_span span = b.unshare();
+    EXPECT_FALSE(a.shares_data(b));
+    EXPECT_FALSE(b.is_shared());
+    EXPECT_TRUE(a.is_shared());
+    for (element<size_t>& e : span) e = 42;
+    EXPECT_EQ(42, b[0]);
+    EXPECT_EQ(0, a[0]);
+    EXPECT_EQ(0, c[0]);
+
+    // A unique buffer isn't copied again
+    EXPECT_EQ(span.data(), b.unshare().data());
+
+    cow_vector<element<size_t> > d = std::move(c);
+    EXPECT_TRUE(c.empty());
+    EXPECT_TRUE(a.shares_data(d));
+    a.clear();
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ(10, d.size());
+    EXPECT_FALSE(d.is_shared());
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, cow_vector_modify_shared) {
+  {
+    cow_vector<element<size_t> > a;
+    for (size_t i = 0; i != 8; ++i) a.push_back(i);
+
+    cow_vector<element<size_t> > b = a;
+    b.push_back(b[0]);
+    cow_vector<element<size_t> > c = a;
+    c.pop_back();
+    cow_vector<element<size_t> > d = a;
+    d.insert(d.begin() + 2, 3, d[7]);
+    cow_vector<element<size_t> > e = a;
+    e.erase(e.begin(), e.begin() + 4);
+    cow_vector<element<size_t> > f = a;
+    f.reserve(100);
+
+    ASSERT_EQ(8, a.size());
+    for (size_t i = 0; i != 8; ++i) EXPECT_EQ(i, a[i]);
+    EXPECT_FALSE(a.is_shared());
+    EXPECT_EQ(9, b.size());
+    EXPECT_EQ(0, b.back());
+    EXPECT_EQ(7, c.size());
+    EXPECT_EQ(11, d.size());
+    EXPECT_EQ(7, d[4]);
+    EXPECT_EQ(2, d[5]);
+    EXPECT_EQ(4, e.size());
+    EXPECT_EQ(4, e.front());
+    EXPECT_EQ(100, f.capacity());
+    EXPECT_EQ(7, f.back());
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, cow_vector_unshare_throw) {
+  {
+    cow_vector<element<size_t> > a;
+    for (size_t i = 0; i != 10; ++i) a.push_back(i);
+    cow_vector<element<size_t> > b = a;
+
+    element<size_t>::set_throw_countdown(5);
+    EXPECT_THROW(b.unshare(), std::runtime_error);
+    EXPECT_TRUE(a.shares_data(b));
+    element<size_t>::set_throw_countdown(3);
+    EXPECT_THROW(b.push_back(42), std::runtime_error);
+    EXPECT_TRUE(a.shares_data(b));
+    element<size_t>::set_throw_countdown(0);
+    ASSERT_EQ(10, b.size());
+    for (size_t i = 0; i != 10; ++i) EXPECT_EQ(i, b[i]);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, cow_vector_threads) {
+  cow_vector<size_t> a;
+  for (size_t i = 0; i != 1000; ++i) a.push_back(i);
+  std::vector<std::thread> threads;
+  std::vector<size_t> sums(4);
+  for (size_t t = 0; t != sums.size(); ++t) {
+    threads.emplace_back([&a, &sums, t] {
+      for (size_t r = 0; r != 1000; ++r) {
+        cow_vector<size_t> copy = a;
+        if (r % 10 == 0) copy.unshare()[0] = t;
+        sums[t] += copy[999];
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  for (size_t sum : sums) EXPECT_EQ(999 * 1000, sum);
+  EXPECT_FALSE(a.is_shared());
+  EXPECT_EQ(0, a[0]);
+}
+
+TEST(correctness_random, cow_vector_copies) {
+  std::mt19937 rng(47);
+  {
+    std::vector<cow_vector<element<size_t> > > copies(4);
+    std::vector<std::vector<size_t> > expected(4);
+    for (size_t i = 0; i != 2000; ++i) {
+      size_t k = rng() % copies.size();
+      cow_vector<element<size_t> >& a = copies[k];
+      std::vector<size_t>& e = expected[k];
+      size_t pos = e.empty() ? 0 : rng() % e.size();
+      switch (rng() % 6) {
+      case 0: {
+        size_t from = rng() % copies.size();
+        a = copies[from];
+        e = expected[from];
+        break;
+      }
+      case 1:
+        a.push_back(i);
+        e.push_back(i);
+        break;
+      case 2:
+        a.insert(a.begin() + pos, 2, i);
+        e.insert(e.begin() + pos, 2, i);
+        break;
+      case 3:
+        if (!e.empty()) {
+          a.erase(a.begin() + pos);
+          e.erase(e.begin() + pos);
+        }
+        break;
+      case 4:
+        if (!e.empty()) {
+          a.unshare()[pos] = i;
+          e[pos] = i;
+        }
+        break;
+      case 5:
+        a.shrink_to_fit();
+        break;
+      }
+      for (size_t j = 0; j != copies.size(); ++j) {
+        ASSERT_EQ(expected[j].size(), copies[j].size());
+        for (size_t l = 0; l != expected[j].size(); ++l) ASSERT_EQ(expected[j][l], copies[j][l]);
+      }
+    }
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, concurrent_vector_push_back) {
+  concurrent_vector<size_t> a;
+  size_t const threads_count = 4;
+  size_t const per_thread = 100000;
+  std::vector<std::thread> threads;
+  std::vector<size_t*> first(threads_count);
+  for (size_t t = 0; t != threads_count; ++t) {
+    threads.emplace_back([&a, &first, t] {
+      size_t i = a.push_back(t * per_thread);
+      first[t] = &a[i];
+      for (size_t j = 1; j != per_thread; ++j) {
+        if (j % 2 == 0) a.push_back(t * per_thread + j);
+        else a.emplace_back(t * per_thread + j);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  ASSERT_EQ(threads_count * per_thread, a.size());
+  std::vector<bool> seen(threads_count * per_thread);
+  for (size_t i = 0; i != a.size(); ++i) {
+    ASSERT_FALSE(seen[a[i]]);
+    seen[a[i]] = true;
+  }
+  // Elements never move
+  for (size_t t = 0; t != threads_count; ++t) EXPECT_EQ(t * per_thread, *first[t]);
+}
+
+TEST(correctness, concurrent_vector_segments) {
+  {
+    concurrent_vector<element<size_t> > a;
+    a.reserve(100);
+    element<size_t>& first = a.emplace_back(0);
+    for (size_t i = 1; i != 1000; ++i) a.push_back(i);
+    EXPECT_EQ(&first, &a[0]);
+    for (size_t i = 0; i != 1000; ++i) EXPECT_EQ(i, as_const(a)[i]);
+
+    element<size_t>::set_throw_countdown(1);
+    EXPECT_THROW(a.push_back(1000), std::runtime_error);
+    EXPECT_EQ(1001, a.size());
+    a.push_back(1001);
+    EXPECT_EQ(1001, a[1001]);
+
+    a.clear();
+    EXPECT_TRUE(a.empty());
+    element<size_t>::expect_no_instances();
+    a.push_back(1);
+    EXPECT_EQ(1, a[0]);
+
+    element<size_t>::set_throw_countdown(1);
+    EXPECT_THROW(a.push_back(2), std::runtime_error);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+namespace {
+  // element isn't thread-safe, this one counts its instances atomically
+  struct parallel_element {
+    parallel_element(size_t val) : val(val) {
+      ++alive;
+    }
+
+    parallel_element(parallel_element const& other) : val(other.val) {
+      if (copies_left.fetch_sub(1) == 1) throw std::runtime_error("copy failed");
+      ++alive;
+    }
+
+    ~parallel_element() {
+      --alive;
+    }
+
+    size_t val;
+    static std::atomic<long> alive;
+    static std::atomic<long> copies_left;
+  };
+
+  std::atomic<long> parallel_element::alive(0);
+  std::atomic<long> parallel_element::copies_left(-1);
+}
+
+TEST(correctness, parallel_bulk) {
+  parallel_policy policy(4, 1000);
+  vector<size_t> a;
+  a.resize(100000, 7, policy);
+  EXPECT_EQ(100000, a.size());
+  for (size_t i = 0; i != a.size(); ++i) a[i] = i;
+
+  vector<size_t> b(a, policy);
+  ASSERT_EQ(100000, b.size());
+  for (size_t i = 0; i != b.size(); ++i) ASSERT_EQ(i, b[i]);
+
+  b.resize(10);
+  b.resize(20000, b[3], policy);
+  EXPECT_EQ(3, b[19999]);
+  b.assign(a.begin() + 5, a.end(), policy);
+  EXPECT_EQ(99995, b.size());
+  EXPECT_EQ(5, b[0]);
+  b.assign(200000, 1, policy);
+  EXPECT_EQ(200000, b.size());
+  EXPECT_EQ(1, b[199999]);
+  b.assign(3, 2);
+  EXPECT_EQ(3, b.size());
+  b.assign(a.begin(), a.begin() + 2);
+  EXPECT_EQ(2, b.size());
+  EXPECT_EQ(1, b[1]);
+  b.reserve(50000);
+  b.resize(50000);
+  EXPECT_EQ(0, b[49999]);
+}
+
+TEST(correctness, parallel_bulk_throw) {
+  parallel_policy policy(4, 100);
+  {
+    vector<parallel_element> a;
+    a.resize(10000, 1, policy);
+    long alive = parallel_element::alive;
+
+    parallel_element::copies_left = 5000;
+    typedef vector<parallel_element> vector_t;
+    EXPECT_THROW(vector_t b(a, policy), std::runtime_error);
+    EXPECT_EQ(alive, parallel_element::alive);
+
+    // No reallocation, so the copy fails inside a chunk of the parallel fill
+    a.reserve(20000);
+    parallel_element::copies_left = 5000;
+    EXPECT_THROW(a.resize(20000, 2, policy), std::runtime_error);
+    EXPECT_EQ(alive, parallel_element::alive);
+    EXPECT_EQ(10000, a.size());
+    EXPECT_EQ(1, a[9999].val);
+
+    parallel_element::copies_left = 9000;
+    vector<parallel_element> c;
+    EXPECT_THROW(c.assign(a.begin(), a.end(), policy), std::runtime_error);
+    EXPECT_TRUE(c.empty());
+    EXPECT_EQ(alive, parallel_element::alive);
+    parallel_element::copies_left = -1;
+  }
+  EXPECT_EQ(0, parallel_element::alive);
+}
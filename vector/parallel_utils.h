@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "element_utils.h"
+
+// How bulk operations of vector split their work : at most threads threads,
+// each constructing at least min_chunk elements, so small vectors stay on one thread.
+struct parallel_policy
+{
+    constexpr static size_t DEFAULT_MIN_CHUNK = 1 << 16;
+
+    explicit parallel_policy(size_t threads = default_threads(), size_t min_chunk = DEFAULT_MIN_CHUNK)
+            : threads(threads ? threads : 1), min_chunk(min_chunk ? min_chunk : 1)
+    {}
+
+    static size_t default_threads()
+    {
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    size_t threads;
+    size_t min_chunk;
+};
+
+// Construction of raw buffers by several threads. Each thread constructs a contiguous
+// chunk and so is the first to touch its pages : fresh memory of large buffers is
+// faulted in by the threads that fill it, in parallel and on their NUMA nodes.
+namespace parallel_utils
+{
+    // Calls construct(begin, end) for disjoint chunks covering [0, n), the calling thread
+    // takes the first one. construct leaves its chunk empty if it throws. If any chunk
+    // throws, the others are destroyed and the first exception is rethrown.
+    template <typename T, typename Construct>
+    void construct_chunks(T* dst, size_t n, parallel_policy const& policy, Construct const& construct)
+    {
+        size_t chunks = std::min(policy.threads, n / policy.min_chunk);
+        if (chunks <= 1)
+        {
+            construct(0, n);
+            return;
+        }
+        auto chunk_begin = [n, chunks](size_t chunk) {
+            return chunk == chunks ? n : n / chunks * chunk;
+        };
+        std::vector<std::exception_ptr> errors(chunks);
+        auto run = [&](size_t chunk) {
+            try
+            {
+                construct(chunk_begin(chunk), chunk_begin(chunk + 1));
+            }
+            catch (...)
+            {
+                errors[chunk] = std::current_exception();
+            }
+        };
+        std::vector<std::thread> threads;
+        threads.reserve(chunks - 1);
+        size_t chunk = 1;
+        try
+        {
+            for (; chunk != chunks; ++chunk)
+            {
+                threads.emplace_back(run, chunk);
+            }
+        }
+        catch (...)
+        {
+            // No more threads : the rest is done here
+            for (; chunk != chunks; ++chunk)
+            {
+                run(chunk);
+            }
+        }
+        run(0);
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        auto error = std::find_if(errors.begin(), errors.end(), [](std::exception_ptr const& e) {
+            return static_cast<bool>(e);
+        });
+        if (error == errors.end())
+        {
+            return;
+        }
+        for (size_t c = 0; c != chunks; ++c)
+        {
+            if (!errors[c])
+            {
+                element_utils::destroy_all(dst + chunk_begin(c), chunk_begin(c + 1) - chunk_begin(c));
+            }
+        }
+        std::rethrow_exception(*error);
+    }
+
+    // Copy-constructs dst[i] from first[i] for i in [0, n)
+    template <typename T, typename RandomIt>
+    void uninitialized_copy(RandomIt first, size_t n, T* dst, parallel_policy const& policy)
+    {
+        construct_chunks(dst, n, policy, [&](size_t begin, size_t end) {
+            std::uninitialized_copy(first + begin, first + end, dst + begin);
+        });
+    }
+
+    // Copy-constructs n elements of dst from val
+    template <typename T>
+    void uninitialized_fill(T* dst, size_t n, T const& val, parallel_policy const& policy)
+    {
+        construct_chunks(dst, n, policy, [&](size_t begin, size_t end) {
+            std::uninitialized_fill(dst + begin, dst + end, val);
+        });
+    }
+}
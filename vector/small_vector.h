@@ -0,0 +1,706 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "element_utils.h"
+
+// vector with room for N elements inside the object : nothing is allocated until
+// the size exceeds N. Growth past N moves the elements to the heap, shrink_to_fit
+// brings them back if they fit.
+// Inline elements can't be moved by swapping pointers, so moving and swapping
+// small_vectors move the elements one by one : these operations are nothrow
+// only if T's move is nothrow.
+// The heap buffer comes from Allocator, which is handled as in vector.
+template <typename T, size_t N, typename Allocator = std::allocator<T>>
+struct small_vector : private Allocator
+{
+    static_assert(N > 0, "small_vector needs room for at least one inline element");
+
+    typedef T* iterator;
+    typedef T const* const_iterator;
+    typedef Allocator allocator_type;
+
+    small_vector();                         // O(1) nothrow
+    explicit small_vector(Allocator const&); // O(1) nothrow
+    small_vector(small_vector const&);      // O(N) strong
+    small_vector(small_vector const&, Allocator const&); // O(N) strong
+    small_vector& operator=(small_vector const& other); // O(N) strong
+    small_vector(small_vector&&) noexcept(std::is_nothrow_move_constructible<T>::value); // O(N)
+    // Nothrow if T's move is nothrow and the allocator propagates on move assignment,
+    // with unequal allocators the elements are moved into memory of our allocator
+    small_vector& operator=(small_vector&& other) noexcept(
+            std::is_nothrow_move_constructible<T>::value &&
+            std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value); // O(N)
+
+    ~small_vector();                        // O(N) nothrow
+
+    Allocator get_allocator() const;        // O(1) nothrow
+
+    T& operator[](size_t i);                // O(1) nothrow
+    T const& operator[](size_t i) const;    // O(1) nothrow
+
+    T* data();                              // O(1) nothrow
+    T const* data() const;                  // O(1) nothrow
+    size_t size() const;                    // O(1) nothrow
+
+    T& front();                             // O(1) nothrow
+    T const& front() const;                 // O(1) nothrow
+
+    T& back();                              // O(1) nothrow
+    T const& back() const;                  // O(1) nothrow
+    void push_back(T const&);               // O(1)* strong
+    void push_back(T&&);                    // O(1)* strong
+    template <typename... Args>
+    T& emplace_back(Args&&... args);        // O(1)* strong
+    void pop_back();                        // O(1) nothrow
+
+    bool empty() const;                     // O(1) nothrow
+    // True while the elements are stored inside the object
+    bool is_inline() const;                 // O(1) nothrow
+
+    size_t capacity() const;                // O(1) nothrow
+    void reserve(size_t);                   // O(N) strong
+    void shrink_to_fit();                   // O(N) strong
+
+    void clear();                           // O(N) nothrow
+
+    // O(1) nothrow if both are on the heap, O(N) otherwise
+    void swap(small_vector&);
+
+    iterator begin();                       // O(1) nothrow
+    iterator end();                         // O(1) nothrow
+
+    const_iterator begin() const;           // O(1) nothrow
+    const_iterator end() const;             // O(1) nothrow
+
+    iterator insert(iterator pos, T const&); // O(N) weak
+    iterator insert(const_iterator pos, T const&); // O(N) weak
+    iterator insert(iterator pos, T&&);     // O(N) weak
+    iterator insert(const_iterator pos, T&&); // O(N) weak
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args); // O(N) weak
+
+    // Each of these reallocates at most once
+    iterator insert(const_iterator pos, size_t n, T const&); // O(N + n) weak
+    template <typename InputIt, typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    iterator insert(const_iterator pos, InputIt first, InputIt last); // O(N + n) weak
+    iterator insert(const_iterator pos, std::initializer_list<T>); // O(N + n) weak
+
+    iterator erase(iterator pos);           // O(N) weak
+    iterator erase(const_iterator pos);     // O(N) weak
+
+    iterator erase(iterator first, iterator last); // O(N) weak
+    iterator erase(const_iterator first, const_iterator last); // O(N) weak
+
+private:
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_t;
+    typedef std::allocator_traits<Allocator> alloc_traits;
+
+    Allocator& alloc();
+    Allocator const& alloc() const;
+    T* inline_data();
+    T* allocate(size_t capacity);
+    void deallocate(T* data, size_t capacity);
+    void move_from(small_vector& other);
+    template <typename InputIt>
+    void insert_range(size_t pos, InputIt first, InputIt last, std::input_iterator_tag);
+    template <typename ForwardIt>
+    void insert_range(size_t pos, ForwardIt first, ForwardIt last, std::forward_iterator_tag);
+    void swap_inline(small_vector& other);
+    size_t get_increased_capacity() const;
+    void new_buffer(size_t new_capacity);
+    template <typename... Args>
+    void emplace_back_realloc(Args&&... args);
+    void full_clear();
+    void init_fields(T* data, size_t size, size_t capacity);
+
+private:
+    T* data_;
+    size_t size_;
+    size_t capacity_;
+    storage_t storage_[N];
+};
+
+// Private methods
+
+template <typename T, size_t N, typename Allocator>
+Allocator& small_vector<T, N, Allocator>::alloc()
+{
+    return *this;
+}
+
+template <typename T, size_t N, typename Allocator>
+Allocator const& small_vector<T, N, Allocator>::alloc() const
+{
+    return *this;
+}
+
+template <typename T, size_t N, typename Allocator>
+T* small_vector<T, N, Allocator>::inline_data()
+{
+    return reinterpret_cast<T*>(storage_);
+}
+
+template <typename T, size_t N, typename Allocator>
+T* small_vector<T, N, Allocator>::allocate(size_t capacity)
+{
+    // Inline storage is free whenever a new buffer is needed : either the elements
+    // are on the heap, or they are inline and the new capacity exceeds N
+    return capacity <= N ? inline_data() : alloc_traits::allocate(alloc(), capacity);
+}
+
+template <typename T, size_t N, typename Allocator>
+void small_vector<T, N, Allocator>::deallocate(T* data, size_t capacity)
+{
+    if (data != inline_data())
+    {
+        alloc_traits::deallocate(alloc(), data, capacity);
+    }
+}
+
+template <typename T, size_t N, typename Allocator>
+void small_vector<T, N, Allocator>::move_from(small_vector<T, N, Allocator>& other)
+{
+    // Requires an empty inline *this
+    if (!other.is_inline())
+    {
+        init_fields(other.data_, other.size_, other.capacity_);
+        other.init_fields(other.inline_data(), 0, N);
+        return;
+    }
+    std::uninitialized_copy(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()),
+                            data_);
+    size_ = other.size_;
+    other.clear();
+}
+
+template <typename T, size_t N, typename Allocator>
+template <typename InputIt>
+void small_vector<T, N, Allocator>::insert_range(size_t pos, InputIt first, InputIt last, std::input_iterator_tag)
+{
+    // The length is unknown, so the elements are appended and rotated into place
+    size_t old_size = size_;
+    for (; first != last; ++first)
+    {
+        emplace_back(*first);
+    }
+    std::rotate(data_ + pos, data_ + old_size, data_ + size_);
+}
+
+template <typename T, size_t N, typename Allocator>
+template <typename ForwardIt>
+void small_vector<T, N, Allocator>::insert_range(size_t pos, ForwardIt first, ForwardIt last, std::forward_iterator_tag)
+{
+    size_t n = std::distance(first, last);
+    if (n == 0)
+    {
+        return;
+    }
+    if (size_ + n <= capacity_)
+    {
+        element_utils::insert_in_place(data_, size_, pos, first, last, n);
+        return;
+    }
+    size_t capacity = std::max(get_increased_capacity(), size_ + n);
+    T* data = allocate(capacity);
+    size_t size = size_;
+    try
+    {
+        std::uninitialized_copy(first, last, data + pos);
+        try
+        {
+            element_utils::relocate_all(data, data_, pos);
+            try
+            {
+                element_utils::relocate_all(data + pos + n, data_ + pos, size - pos);
+            }
+            catch (...)
+            {
+                element_utils::destroy_all(data, pos);
+                throw;
+            }
+        }
+        catch (...)
+        {
+            element_utils::destroy_all(data + pos, n);
+            throw;
+        }
+    }
+    catch (...)
+    {
+        deallocate(data, capacity);
+        throw;
+    }
+    full_clear();
+    init_fields(data, size + n, capacity);
+}
+
+template <typename T, size_t N, typename Allocator>
+void small_vector<T, N, Allocator>::swap_inline(small_vector& other)
+{
+    small_vector& shorter = size_ <= other.size_ ? *this : other;
+    small_vector& longer = size_ <= other.size_ ? other : *this;
+    size_t common = shorter.size_;
+    std::swap_ranges(shorter.data_, shorter.data_ + common, longer.data_);
+    element_utils::relocate_all(shorter.data_ + common, longer.data_ + common, longer.size_ - common);
+    element_utils::destroy_all(longer.data_ + common, longer.size_ - common);
+    std::swap(shorter.size_, longer.size_);
+}
+
+template <typename T, size_t N, typename Allocator>
+size_t small_vector<T, N, Allocator>::get_increased_capacity() const
+{
+    return 2 * capacity_;
+}
+
+template <typename T, size_t N, typename Allocator>
+void small_vector<T, N, Allocator>::new_buffer(size_t new_capacity)
+{
+    T* data = allocate(new_capacity);
+    size_t size = size_;
+    try
+    {
+        element_utils::relocate_all(data, data_, size_);
+    }
+    catch (...)
+    {
+        deallocate(data, new_capacity);
+        throw;
+    }
+    full_clear();
+    init_fields(data, size, std::max(new_capacity, N));
+}
+
+template <typename T, size_t N, typename Allocator>
+template <typename... Args>
+void small_vector<T, N, Allocator>::emplace_back_realloc(Args&&... args)
+{
+    size_t capacity = get_increased_capacity();
+    T* data = allocate(capacity);
+    size_t size = size_;
+    try
+    {
+        // The new element is constructed first : args may refer to the old elements
+        new (data + size) T(std::forward<Args>(args)...);
+        try
+        {
+            element_utils::relocate_all(data, data_, size);
+        }
+        catch (...)
+        {
+            data[size].~T();
+            throw;
+        }
+    }
+    catch (...)
+    {
+        deallocate(data, capacity);
+        throw;
+    }
+    full_clear();
+    init_fields(data, size + 1, capacity);
+}
+
+template <typename T, size_t N, typename Allocator>
+void small_vector<T, N, Allocator>::full_clear()
+{
+    clear();
+    deallocate(data_, capacity_);
+    data_ = inline_data();
+    capacity_ = N;
+}
+
+template <typename T, size_t N, typename Allocator>
+void small_vector<T, N, Allocator>::init_fields(T* data, size_t size, size_t capacity)
+{
+    data_ = data;
+    size_ = size;
+    capacity_ = capacity;
+}
+
+// Public methods
+
+template <typename T, size_t N, typename Allocator>
+small_vector<T, N, Allocator>::small_vector() : small_vector(Allocator())
+{}
+
+template <typename T, size_t N, typename Allocator>
+small_vector<T, N, Allocator>::small_vector(Allocator const& alloc)
+        : Allocator(alloc), data_(inline_data()), size_(0), capacity_(N)
+{}
+
+template <typename T, size_t N, typename Allocator>
+small_vector<T, N, Allocator>::small_vector(small_vector<T, N, Allocator> const& other)
+        : small_vector(other, alloc_traits::select_on_container_copy_construction(other.alloc()))
+{}
+
+template <typename T, size_t N, typename Allocator>
+small_vector<T, N, Allocator>::small_vector(small_vector<T, N, Allocator> const& other, Allocator const& alloc)
+        : small_vector(alloc)
+{
+    T* data = allocate(other.size_);
+    try
+    {
+        element_utils::copy_construct_all(data, other.data_, other.size_);
+    }
+    catch (...)
+    {
+        deallocate(data, other.size_);
+        throw;
+    }
+    init_fields(data, other.size_, std::max(other.size_, N));
+}
+
+template <typename T, size_t N, typename Allocator>
+small_vector<T, N, Allocator>& small_vector<T, N, Allocator>::operator=(small_vector<T, N, Allocator> const& other)
+{
+    if (this != &other)
+    {
+        bool const propagate = alloc_traits::propagate_on_container_copy_assignment::value;
+        small_vector copy(other, propagate ? other.alloc() : alloc());
+        if (propagate)
+        {
+            // Our heap buffer must go away with our old allocator
+            full_clear();
+            alloc() = copy.alloc();
+            move_from(copy);
+        }
+        else
+        {
+            swap(copy);
+        }
+    }
+    return *this;
+}
+
+template <typename T, size_t N, typename Allocator>
+small_vector<T, N, Allocator>::small_vector(small_vector<T, N, Allocator>&& other)
+        noexcept(std::is_nothrow_move_constructible<T>::value)
+        : Allocator(std::move(other.alloc())), data_(inline_data()), size_(0), capacity_(N)
+{
+    move_from(other);
+}
+
+template <typename T, size_t N, typename Allocator>
+small_vector<T, N, Allocator>& small_vector<T, N, Allocator>::operator=(small_vector<T, N, Allocator>&& other)
+        noexcept(std::is_nothrow_move_constructible<T>::value &&
+                 std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value)
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+    full_clear();
+    if (alloc_traits::propagate_on_container_move_assignment::value)
+    {
+        alloc() = std::move(other.alloc());
+    }
+    if (alloc() == other.alloc() || other.is_inline())
+    {
+        move_from(other);
+    }
+    else
+    {
+        // The heap buffer can't change hands, so the elements move into memory of our allocator
+        insert(end(), std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+    }
+    return *this;
+}
+
+template <typename T, size_t N, typename Allocator>
+small_vector<T, N, Allocator>::~small_vector()
+{
+    full_clear();
+}
+
+template <typename T, size_t N, typename Allocator>
+Allocator small_vector<T, N, Allocator>::get_allocator() const
+{
+    return alloc();
+}
+
+template <typename T, size_t N, typename Allocator>
+T& small_vector<T, N, Allocator>::operator[](size_t i)
+{
+    return data_[i];
+}
+
+template <typename T, size_t N, typename Allocator>
+T const& small_vector<T, N, Allocator>::operator[](size_t i) const
+{
+    return data_[i];
+}
+
+template <typename T, size_t N, typename Allocator>
+T* small_vector<T, N, Allocator>::data()
+{
+    return data_;
+}
+
+template <typename T, size_t N, typename Allocator>
+T const* small_vector<T, N, Allocator>::data() const
+{
+    return data_;
+}
+
+template <typename T, size_t N, typename Allocator>
+size_t small_vector<T, N, Allocator>::size() const
+{
+    return size_;
+}
+
+template <typename T, size_t N, typename Allocator>
+T& small_vector<T, N, Allocator>::front()
+{
+    return *data_;
+}
+
+template <typename T, size_t N, typename Allocator>
+T const& small_vector<T, N, Allocator>::front() const
+{
+    return *data_;
+}
+
+template <typename T, size_t N, typename Allocator>
+T& small_vector<T, N, Allocator>::back()
+{
+    return data_[size_ - 1];
+}
+
+template <typename T, size_t N, typename Allocator>
+T const& small_vector<T, N, Allocator>::back() const
+{
+    return data_[size_ - 1];
+}
+
+template <typename T, size_t N, typename Allocator>
+void small_vector<T, N, Allocator>::push_back(T const& val)
+{
+    emplace_back(val);
+}
+
+template <typename T, size_t N, typename Allocator>
+void small_vector<T, N, Allocator>::push_back(T&& val)
+{
+    emplace_back(std::move(val));
+}
+
+template <typename T, size_t N, typename Allocator>
+template <typename... Args>
+T& small_vector<T, N, Allocator>::emplace_back(Args&&... args)
+{
+    if (size_ == capacity_)
+    {
+        emplace_back_realloc(std::forward<Args>(args)...);
+    }
+    else
+    {
+        new (data_ + size_) T(std::forward<Args>(args)...);
+        ++size_;
+    }
+    return back();
+}
+
+template <typename T, size_t N, typename Allocator>
+void small_vector<T, N, Allocator>::pop_back()
+{
+    data_[--size_].~T();
+}
+
+template <typename T, size_t N, typename Allocator>
+bool small_vector<T, N, Allocator>::empty() const
+{
+    return size_ == 0;
+}
+
+template <typename T, size_t N, typename Allocator>
+bool small_vector<T, N, Allocator>::is_inline() const
+{
+    return data_ == reinterpret_cast<T const*>(storage_);
+}
+
+template <typename T, size_t N, typename Allocator>
+size_t small_vector<T, N, Allocator>::capacity() const
+{
+    return capacity_;
+}
+
+template <typename T, size_t N, typename Allocator>
+void small_vector<T, N, Allocator>::reserve(size_t new_capacity)
+{
+    if (new_capacity > capacity_)
+    {
+        new_buffer(new_capacity);
+    }
+}
+
+template <typename T, size_t N, typename Allocator>
+void small_vector<T, N, Allocator>::shrink_to_fit()
+{
+    if (!is_inline() && capacity_ > size_)
+    {
+        new_buffer(size_);
+    }
+}
+
+template <typename T, size_t N, typename Allocator>
+void small_vector<T, N, Allocator>::clear()
+{
+    if (size_)
+    {
+        element_utils::destroy_all(data_, size_);
+        size_ = 0;
+    }
+}
+
+template <typename T, size_t N, typename Allocator>
+void small_vector<T, N, Allocator>::swap(small_vector<T, N, Allocator>& other)
+{
+    using std::swap;
+    if (this == &other)
+    {
+        return;
+    }
+    if (is_inline() && other.is_inline())
+    {
+        swap_inline(other);
+        return;
+    }
+    if (is_inline() || other.is_inline())
+    {
+        // The inline elements move into the inline storage of the other vector,
+        // which gives its heap buffer away
+        small_vector& small = is_inline() ? *this : other;
+        small_vector& large = is_inline() ? other : *this;
+        element_utils::relocate_all(large.inline_data(), small.data_, small.size_);
+        element_utils::destroy_all(small.data_, small.size_);
+        small.data_ = large.data_;
+        large.data_ = large.inline_data();
+    }
+    else
+    {
+        swap(data_, other.data_);
+    }
+    if (alloc_traits::propagate_on_container_swap::value)
+    {
+        swap(alloc(), other.alloc());
+    }
+    swap(size_, other.size_);
+    swap(capacity_, other.capacity_);
+}
+
+template <typename T, size_t N, typename Allocator>
+typename small_vector<T, N, Allocator>::iterator small_vector<T, N, Allocator>::begin()
+{
+    return data_;
+}
+
+template <typename T, size_t N, typename Allocator>
+typename small_vector<T, N, Allocator>::iterator small_vector<T, N, Allocator>::end()
+{
+    return data_ + size_;
+}
+
+template <typename T, size_t N, typename Allocator>
+typename small_vector<T, N, Allocator>::const_iterator small_vector<T, N, Allocator>::begin() const
+{
+    return data_;
+}
+
+template <typename T, size_t N, typename Allocator>
+typename small_vector<T, N, Allocator>::const_iterator small_vector<T, N, Allocator>::end() const
+{
+    return data_ + size_;
+}
+
+template <typename T, size_t N, typename Allocator>
+typename small_vector<T, N, Allocator>::iterator small_vector<T, N, Allocator>::insert(iterator pos, T const& val)
+{
+    return insert(static_cast<const_iterator>(pos), val);
+}
+
+template <typename T, size_t N, typename Allocator>
+typename small_vector<T, N, Allocator>::iterator small_vector<T, N, Allocator>::insert(const_iterator pos, T const& val)
+{
+    return emplace(pos, val);
+}
+
+template <typename T, size_t N, typename Allocator>
+typename small_vector<T, N, Allocator>::iterator small_vector<T, N, Allocator>::insert(iterator pos, T&& val)
+{
+    return insert(static_cast<const_iterator>(pos), std::move(val));
+}
+
+template <typename T, size_t N, typename Allocator>
+typename small_vector<T, N, Allocator>::iterator small_vector<T, N, Allocator>::insert(const_iterator pos, T&& val)
+{
+    return emplace(pos, std::move(val));
+}
+
+template <typename T, size_t N, typename Allocator>
+template <typename... Args>
+typename small_vector<T, N, Allocator>::iterator small_vector<T, N, Allocator>::emplace(const_iterator pos, Args&&... args)
+{
+    size_t at = pos - begin();
+    emplace_back(std::forward<Args>(args)...);
+    element_utils::move_back_to(data_, size_, at);
+    return begin() + at;
+}
+
+template <typename T, size_t N, typename Allocator>
+typename small_vector<T, N, Allocator>::iterator small_vector<T, N, Allocator>::insert(const_iterator pos, size_t n, T const& val)
+{
+    size_t at = pos - begin();
+    // val may be an element of this vector that is about to be moved
+    T copy(val);
+    typedef element_utils::repeat_iterator<T> repeat_iterator;
+    insert_range(at, repeat_iterator(copy, 0), repeat_iterator(copy, n), std::forward_iterator_tag());
+    return begin() + at;
+}
+
+template <typename T, size_t N, typename Allocator>
+template <typename InputIt, typename>
+typename small_vector<T, N, Allocator>::iterator small_vector<T, N, Allocator>::insert(const_iterator pos, InputIt first, InputIt last)
+{
+    size_t at = pos - begin();
+    insert_range(at, first, last, typename std::iterator_traits<InputIt>::iterator_category());
+    return begin() + at;
+}
+
+template <typename T, size_t N, typename Allocator>
+typename small_vector<T, N, Allocator>::iterator small_vector<T, N, Allocator>::insert(const_iterator pos, std::initializer_list<T> list)
+{
+    return insert(pos, list.begin(), list.end());
+}
+
+template <typename T, size_t N, typename Allocator>
+typename small_vector<T, N, Allocator>::iterator small_vector<T, N, Allocator>::erase(iterator pos)
+{
+    return erase(static_cast<const_iterator>(pos));
+}
+
+template <typename T, size_t N, typename Allocator>
+typename small_vector<T, N, Allocator>::iterator small_vector<T, N, Allocator>::erase(const_iterator pos)
+{
+    return erase(pos, pos + 1);
+}
+
+template <typename T, size_t N, typename Allocator>
+typename small_vector<T, N, Allocator>::iterator small_vector<T, N, Allocator>::erase(iterator first, iterator last)
+{
+    return erase(static_cast<const_iterator>(first), static_cast<const_iterator>(last));
+}
+
+template <typename T, size_t N, typename Allocator>
+typename small_vector<T, N, Allocator>::iterator small_vector<T, N, Allocator>::erase(const_iterator first, const_iterator last)
+{
+    size_t shift = first - begin();
+    element_utils::erase_range(data_, size_, shift, last - begin());
+    return begin() + shift;
+}
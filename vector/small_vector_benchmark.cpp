@@ -0,0 +1,76 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "vector.h"
+#include "small_vector.h"
+
+// Builds many short containers of k elements by push_back and prints the number
+// of heap allocations and the time per container for vector and small_vector<T, 8>.
+// Up to 8 elements small_vector shouldn't allocate at all.
+
+namespace {
+    size_t const CONTAINERS = 1 << 18;
+    size_t allocations = 0;
+
+    // Makes the compiler assume that the value is read and written
+    template <typename T>
+    void escape(T& value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    template <typename V, typename T>
+    void measure(size_t k, T const& value, size_t& allocs, double& time) {
+        size_t start_allocations = allocations;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i != CONTAINERS; ++i) {
+            V v;
+            for (size_t j = 0; j != k; ++j) {
+                v.push_back(value);
+            }
+            escape(v);
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        allocs = allocations - start_allocations;
+        time = elapsed.count() / CONTAINERS;
+    }
+
+    template <typename T>
+    void run(char const* name, T const& value) {
+        std::printf("%-12s  vector allocs/ns   small_vector allocs/ns\n", name);
+        for (size_t k : {0, 1, 2, 4, 8, 9, 16}) {
+            size_t vector_allocs, small_allocs;
+            double vector_time, small_time;
+            measure<vector<T>>(k, value, vector_allocs, vector_time);
+            measure<small_vector<T, 8>>(k, value, small_allocs, small_time);
+            std::printf("  k = %2zu      %6.2f %8.1f      %6.2f %8.1f\n", k,
+                        static_cast<double>(vector_allocs) / CONTAINERS, vector_time,
+                        static_cast<double>(small_allocs) / CONTAINERS, small_time);
+        }
+    }
+}
+
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+int main() {
+    run("int", 42);
+    // Long enough to be on the heap itself, so every element costs an allocation
+    run("std::string", std::string(32, 'x'));
+    return 0;
+}
@@ -1,20 +1,48 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
-
-template <typename T>
-struct vector
+#include "element_utils.h"
+#include "growth_policy.h"
+#include "parallel_utils.h"
+
+// The allocator only provides memory, elements are constructed in place.
+// It is copied, moved and swapped along with the buffer as
+// std::allocator_traits prescribes. Swapping vectors with unequal allocators
+// that don't propagate on swap is undefined, as for std::vector.
+// Growth decides the capacity after a reallocation, see growth_policy.h. If the allocator
+// can reallocate, trivially copyable elements are grown through it instead of being copied.
+template <typename T, typename Allocator = std::allocator<T>, typename Growth = doubling_growth>
+struct vector : private Allocator
 {
     typedef T* iterator;
     typedef T const* const_iterator;
+    typedef Allocator allocator_type;
 
     vector();                               // O(1) nothrow
+    explicit vector(Allocator const&);      // O(1) nothrow
     vector(vector const&);                  // O(N) strong
+    vector(vector const&, Allocator const&); // O(N) strong
+    // The bulk operations taking a parallel_policy construct the elements on several
+    // threads, see parallel_utils.h. If an element throws, all new ones are destroyed.
+    vector(vector const&, parallel_policy const&); // O(N) strong
     vector& operator=(vector const& other); // O(N) strong
+    vector(vector&&) noexcept;              // O(1) nothrow
+    // O(N) nothrow if the allocator propagates on move assignment or the allocators
+    // are equal, otherwise the elements are moved one by one into our own memory
+    vector& operator=(vector&& other)
+            noexcept(std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value);
 
     ~vector();                              // O(N) nothrow
 
+    Allocator get_allocator() const;        // O(1) nothrow
+
     T& operator[](size_t i);                // O(1) nothrow
     T const& operator[](size_t i) const;    // O(1) nothrow
 
@@ -28,6 +56,9 @@ struct vector
     T& back();                              // O(1) nothrow
     T const& back() const;                  // O(1) nothrow
     void push_back(T const&);               // O(1)* strong
+    void push_back(T&&);                    // O(1)* strong
+    template <typename... Args>
+    T& emplace_back(Args&&... args);        // O(1)* strong
     void pop_back();                        // O(1) nothrow
 
     bool empty() const;                     // O(1) nothrow
@@ -36,6 +67,21 @@ struct vector
     void reserve(size_t);                   // O(N) strong
     void shrink_to_fit();                   // O(N) strong
 
+    // Copies of val are appended or the tail is erased. With reserve, the reserved
+    // memory is filled without reallocation.
+    void resize(size_t n);                  // O(N + n) strong
+    void resize(size_t n, T const& val);    // O(N + n) strong
+    void resize(size_t n, T const& val, parallel_policy const&); // O(N + n) strong
+
+    // If n exceeds the capacity, the old buffer is freed first and the new one is
+    // filled right away : there is no relocation and no copy of the old elements
+    void assign(size_t n, T const& val);    // O(N + n) weak
+    void assign(size_t n, T const& val, parallel_policy const&); // O(N + n) weak
+    template <typename InputIt, typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    void assign(InputIt first, InputIt last); // O(N + n) weak
+    template <typename RandomIt, typename = typename std::enable_if<!std::is_integral<RandomIt>::value>::type>
+    void assign(RandomIt first, RandomIt last, parallel_policy const&); // O(N + n) weak
+
     void clear();                           // O(N) nothrow
 
     void swap(vector&);                     // O(1) nothrow
@@ -48,6 +94,16 @@ struct vector
 
     iterator insert(iterator pos, T const&); // O(N) weak
     iterator insert(const_iterator pos, T const&); // O(N) weak
+    iterator insert(iterator pos, T&&);     // O(N) weak
+    iterator insert(const_iterator pos, T&&); // O(N) weak
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args); // O(N) weak
+
+    // Each of these reallocates at most once
+    iterator insert(const_iterator pos, size_t n, T const&); // O(N + n) weak
+    template <typename InputIt, typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    iterator insert(const_iterator pos, InputIt first, InputIt last); // O(N + n) weak
+    iterator insert(const_iterator pos, std::initializer_list<T>); // O(N + n) weak
 
     iterator erase(iterator pos);           // O(N) weak
     iterator erase(const_iterator pos);     // O(N) weak
@@ -56,11 +112,31 @@ struct vector
     iterator erase(const_iterator first, const_iterator last); // O(N) weak
 
 private:
-    void destroy_all(T* data, size_t i);
-    void copy_construct_all(T* dst, T const* src, size_t size);
-    size_t get_increased_capacity() const;
+    typedef std::allocator_traits<Allocator> alloc_traits;
+    typedef std::integral_constant<bool, element_utils::trivially_copyable<T>::value
+                                         && has_reallocate<Allocator>::value> reallocatable;
+
+    Allocator& alloc();
+    Allocator const& alloc() const;
+    T* allocate(size_t capacity);
+    void deallocate(T* data, size_t capacity);
+    void swap_fields(vector& other);
+    template <typename InputIt>
+    void insert_range(size_t pos, InputIt first, InputIt last, std::input_iterator_tag);
+    template <typename ForwardIt>
+    void insert_range(size_t pos, ForwardIt first, ForwardIt last, std::forward_iterator_tag);
+    template <typename ForwardIt>
+    void insert_range_realloc(size_t pos, ForwardIt first, ForwardIt last, size_t n, std::true_type);
+    template <typename ForwardIt>
+    void insert_range_realloc(size_t pos, ForwardIt first, ForwardIt last, size_t n, std::false_type);
+    size_t get_increased_capacity(size_t required) const;
     void new_buffer(size_t new_capacity);
-    void push_back_realloc(T const&);
+    void new_buffer(size_t new_capacity, std::true_type);
+    void new_buffer(size_t new_capacity, std::false_type);
+    template <typename... Args>
+    void emplace_back_realloc(std::true_type, Args&&... args);
+    template <typename... Args>
+    void emplace_back_realloc(std::false_type, Args&&... args);
     void full_clear();
     void init_fields(T* data, size_t size, size_t capacity);
 
@@ -72,100 +148,209 @@ private:
 
 // Private methods
 
-template <typename T>
-void vector<T>::destroy_all(T* data, size_t i)
+template <typename T, typename Allocator, typename Growth>
+Allocator& vector<T, Allocator, Growth>::alloc()
 {
-    for (; i != 0; --i)
+    return *this;
+}
+
+template <typename T, typename Allocator, typename Growth>
+Allocator const& vector<T, Allocator, Growth>::alloc() const
+{
+    return *this;
+}
+
+template <typename T, typename Allocator, typename Growth>
+T* vector<T, Allocator, Growth>::allocate(size_t capacity)
+{
+    return alloc_traits::allocate(alloc(), capacity);
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::deallocate(T* data, size_t capacity)
+{
+    alloc_traits::deallocate(alloc(), data, capacity);
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::swap_fields(vector<T, Allocator, Growth>& other)
+{
+    using std::swap;
+    swap(data_, other.data_);
+    swap(size_, other.size_);
+    swap(capacity_, other.capacity_);
+}
+
+template <typename T, typename Allocator, typename Growth>
+template <typename InputIt>
+void vector<T, Allocator, Growth>::insert_range(size_t pos, InputIt first, InputIt last, std::input_iterator_tag)
+{
+    // The length is unknown, so the elements are appended and rotated into place
+    size_t old_size = size_;
+    for (; first != last; ++first)
+    {
+        emplace_back(*first);
+    }
+    std::rotate(data_ + pos, data_ + old_size, data_ + size_);
+}
+
+template <typename T, typename Allocator, typename Growth>
+template <typename ForwardIt>
+void vector<T, Allocator, Growth>::insert_range(size_t pos, ForwardIt first, ForwardIt last, std::forward_iterator_tag)
+{
+    size_t n = std::distance(first, last);
+    if (n == 0)
+    {
+        return;
+    }
+    if (size_ + n <= capacity_)
     {
-        data[i - 1].~T();
+        element_utils::insert_in_place(data_, size_, pos, first, last, n);
+        return;
     }
+    insert_range_realloc(pos, first, last, n, reallocatable());
 }
 
-template <typename T>
-void vector<T>::copy_construct_all(T* dst, T const* src, size_t size)
+template <typename T, typename Allocator, typename Growth>
+template <typename ForwardIt>
+void vector<T, Allocator, Growth>::insert_range_realloc(size_t pos, ForwardIt first, ForwardIt last, size_t n,
+                                                        std::true_type)
 {
-    size_t i = 0;
+    new_buffer(get_increased_capacity(size_ + n), std::true_type());
+    element_utils::insert_in_place(data_, size_, pos, first, last, n);
+}
+
+template <typename T, typename Allocator, typename Growth>
+template <typename ForwardIt>
+void vector<T, Allocator, Growth>::insert_range_realloc(size_t pos, ForwardIt first, ForwardIt last, size_t n,
+                                                        std::false_type)
+{
+    size_t capacity = get_increased_capacity(size_ + n);
+    T* data = allocate(capacity);
+    size_t size = size_;
     try
     {
-        for (; i != size; ++i)
+        std::uninitialized_copy(first, last, data + pos);
+        try
         {
-            new (dst + i) T(src[i]);
+            element_utils::relocate_all(data, data_, pos);
+            try
+            {
+                element_utils::relocate_all(data + pos + n, data_ + pos, size - pos);
+            }
+            catch (...)
+            {
+                element_utils::destroy_all(data, pos);
+                throw;
+            }
+        }
+        catch (...)
+        {
+            element_utils::destroy_all(data + pos, n);
+            throw;
         }
     }
     catch (...)
     {
-        destroy_all(dst, i);
+        deallocate(data, capacity);
         throw;
     }
+    full_clear();
+    init_fields(data, size + n, capacity);
 }
 
+template <typename T, typename Allocator, typename Growth>
+size_t vector<T, Allocator, Growth>::get_increased_capacity(size_t required) const
+{
+    return Growth::next_capacity(capacity_, required, sizeof(T));
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::new_buffer(size_t new_capacity)
+{
+    new_buffer(new_capacity, reallocatable());
+}
 
-template <typename T>
-size_t vector<T>::get_increased_capacity() const
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::new_buffer(size_t new_capacity, std::true_type)
 {
-    return capacity_ ? 2 * capacity_ : 1;
+    data_ = data_ ? ::reallocate(alloc(), data_, capacity_, new_capacity) : allocate(new_capacity);
+    capacity_ = new_capacity;
 }
 
-template <typename T>
-void vector<T>::new_buffer(size_t new_capacity)
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::new_buffer(size_t new_capacity, std::false_type)
 {
-    T* data = static_cast<T*>(operator new (sizeof(T) * new_capacity));
+    T* data = allocate(new_capacity);
     size_t size = size_;
     try
     {
-        copy_construct_all(data, data_, size_);
+        element_utils::relocate_all(data, data_, size_);
     }
     catch (...)
     {
-        operator delete(data);
+        deallocate(data, new_capacity);
         throw;
     }
     full_clear();
     init_fields(data, size, new_capacity);
 }
 
-template <typename T>
-void vector<T>::push_back_realloc(const T & val)
+template <typename T, typename Allocator, typename Growth>
+template <typename... Args>
+void vector<T, Allocator, Growth>::emplace_back_realloc(std::true_type, Args&&... args)
 {
-    size_t capacity = get_increased_capacity();
-    T* data = static_cast<T*>(operator new (sizeof(T) * capacity));
+    // args may refer to the old elements, which reallocate invalidates
+    T val(std::forward<Args>(args)...);
+    new_buffer(get_increased_capacity(size_ + 1), std::true_type());
+    new (data_ + size_) T(val);
+    ++size_;
+}
+
+template <typename T, typename Allocator, typename Growth>
+template <typename... Args>
+void vector<T, Allocator, Growth>::emplace_back_realloc(std::false_type, Args&&... args)
+{
+    size_t capacity = get_increased_capacity(size_ + 1);
+    T* data = allocate(capacity);
     size_t size = size_;
     try
     {
-        copy_construct_all(data, data_, size_);
+        // The new element is constructed first : args may refer to the old elements
+        new (data + size) T(std::forward<Args>(args)...);
         try
         {
-            new (data + size_) T(val);
+            element_utils::relocate_all(data, data_, size);
         }
         catch (...)
         {
-            destroy_all(data, size_);
+            data[size].~T();
             throw;
         }
     }
     catch (...)
     {
-        operator delete (data);
+        deallocate(data, capacity);
         throw;
     }
     full_clear();
     init_fields(data, size + 1, capacity);
 }
 
-template <typename T>
-void vector<T>::full_clear()
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::full_clear()
 {
     clear();
     if (data_)
     {
-        operator delete (data_);
+        deallocate(data_, capacity_);
     }
     data_ = nullptr;
     capacity_ = 0;
 }
 
-template <typename T>
-void vector<T>::init_fields(T* data, size_t size, size_t capacity)
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::init_fields(T* data, size_t size, size_t capacity)
 {
     data_ = data;
     size_ = size;
@@ -174,134 +359,221 @@ void vector<T>::init_fields(T* data, size_t size, size_t capacity)
 
 // Public methods
 
-template <typename T>
-vector<T>::vector() : data_(nullptr), size_(0), capacity_(0)
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector() : vector(Allocator())
+{}
+
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(Allocator const& alloc) : Allocator(alloc), data_(nullptr), size_(0), capacity_(0)
+{}
+
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(vector<T, Allocator, Growth> const& other)
+        : vector(other, alloc_traits::select_on_container_copy_construction(other.alloc()))
 {}
 
-template <typename T>
-vector<T>::vector(vector<T> const& other) : vector()
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(vector<T, Allocator, Growth> const& other, Allocator const& alloc) : vector(alloc)
+{
+    if (other.size_ > 0)
+    {
+        T* data = allocate(other.size_);
+        try
+        {
+            element_utils::copy_construct_all(data, other.data(), other.size_);
+        }
+        catch (...)
+        {
+            deallocate(data, other.size_);
+            throw;
+        }
+        init_fields(data, other.size_, other.size_);
+    }
+}
+
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(vector<T, Allocator, Growth> const& other, parallel_policy const& policy)
+        : vector(alloc_traits::select_on_container_copy_construction(other.alloc()))
 {
     if (other.size_ > 0)
     {
-        T* data = static_cast<T*>(operator new (sizeof(T) * other.size_));
+        T* data = allocate(other.size_);
         try
         {
-            copy_construct_all(data, other.data(), other.size_);
+            parallel_utils::uninitialized_copy(other.data_, other.size_, data, policy);
         }
         catch (...)
         {
-            operator delete(data);
+            deallocate(data, other.size_);
             throw;
         }
         init_fields(data, other.size_, other.size_);
     }
 }
 
-template <typename T>
-vector<T>& vector<T>::operator=(vector<T> const& other)
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>& vector<T, Allocator, Growth>::operator=(vector<T, Allocator, Growth> const& other)
 {
     if (this != &other)
     {
-        vector copy = other;
-        swap(copy);
+        bool const propagate = alloc_traits::propagate_on_container_copy_assignment::value;
+        vector copy(other, propagate ? other.alloc() : alloc());
+        swap_fields(copy);
+        if (propagate)
+        {
+            using std::swap;
+            swap(alloc(), copy.alloc());
+        }
     }
     return *this;
 }
 
-template <typename T>
-vector<T>::~vector()
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(vector<T, Allocator, Growth>&& other) noexcept
+        : Allocator(std::move(other.alloc())), data_(nullptr), size_(0), capacity_(0)
+{
+    swap_fields(other);
+}
+
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>& vector<T, Allocator, Growth>::operator=(vector<T, Allocator, Growth>&& other)
+        noexcept(std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value)
+{
+    bool const propagate = alloc_traits::propagate_on_container_move_assignment::value;
+    if (propagate || alloc() == other.alloc())
+    {
+        vector copy = std::move(other);
+        swap_fields(copy);
+        if (propagate)
+        {
+            using std::swap;
+            swap(alloc(), copy.alloc());
+        }
+    }
+    else
+    {
+        // The buffer can't change hands, so the elements move into memory of our allocator
+        vector copy(alloc());
+        copy.insert(copy.end(), std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+        swap_fields(copy);
+    }
+    return *this;
+}
+
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::~vector()
 {
     full_clear();
 }
 
-template <typename T>
-T& vector<T>::operator[](size_t i)
+template <typename T, typename Allocator, typename Growth>
+Allocator vector<T, Allocator, Growth>::get_allocator() const
+{
+    return alloc();
+}
+
+template <typename T, typename Allocator, typename Growth>
+T& vector<T, Allocator, Growth>::operator[](size_t i)
 {
     return data_[i];
 }
 
-template <typename T>
-T const& vector<T>::operator[](size_t i) const
+template <typename T, typename Allocator, typename Growth>
+T const& vector<T, Allocator, Growth>::operator[](size_t i) const
 {
     return data_[i];
 }
 
-template <typename T>
-T* vector<T>::data()
+template <typename T, typename Allocator, typename Growth>
+T* vector<T, Allocator, Growth>::data()
 {
     return data_;
 }
 
-template <typename T>
-T const* vector<T>::data() const
+template <typename T, typename Allocator, typename Growth>
+T const* vector<T, Allocator, Growth>::data() const
 {
     return data_;
 }
 
-template <typename T>
-size_t vector<T>::size() const
+template <typename T, typename Allocator, typename Growth>
+size_t vector<T, Allocator, Growth>::size() const
 {
     return size_;
 }
 
-template <typename T>
-T& vector<T>::front()
+template <typename T, typename Allocator, typename Growth>
+T& vector<T, Allocator, Growth>::front()
 {
     return *data_;
 }
 
-template <typename T>
-T const& vector<T>::front() const
+template <typename T, typename Allocator, typename Growth>
+T const& vector<T, Allocator, Growth>::front() const
 {
     return *data_;
 }
 
-template <typename T>
-T& vector<T>::back()
+template <typename T, typename Allocator, typename Growth>
+T& vector<T, Allocator, Growth>::back()
 {
     return data_[size_ - 1];
 }
 
-template <typename T>
-T const& vector<T>::back() const
+template <typename T, typename Allocator, typename Growth>
+T const& vector<T, Allocator, Growth>::back() const
 {
     return data_[size_ - 1];
 }
 
-template <typename T>
-void vector<T>::push_back(T const& val)
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::push_back(T const& val)
+{
+    emplace_back(val);
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::push_back(T&& val)
+{
+    emplace_back(std::move(val));
+}
+
+template <typename T, typename Allocator, typename Growth>
+template <typename... Args>
+T& vector<T, Allocator, Growth>::emplace_back(Args&&... args)
 {
     if (size_ == capacity_)
     {
-        push_back_realloc(val);
+        emplace_back_realloc(reallocatable(), std::forward<Args>(args)...);
     }
     else
     {
-        new (data_ + size_) T(val);
+        new (data_ + size_) T(std::forward<Args>(args)...);
         ++size_;
     }
+    return back();
 }
 
-template <typename T>
-void vector<T>::pop_back()
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::pop_back()
 {
     data_[--size_].~T();
 }
 
-template <typename T>
-bool vector<T>::empty() const
+template <typename T, typename Allocator, typename Growth>
+bool vector<T, Allocator, Growth>::empty() const
 {
     return size_ == 0;
 }
 
-template <typename T>
-size_t vector<T>::capacity() const
+template <typename T, typename Allocator, typename Growth>
+size_t vector<T, Allocator, Growth>::capacity() const
 {
     return capacity_;
 }
 
-template <typename T>
-void vector<T>::reserve(size_t new_capacity)
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::reserve(size_t new_capacity)
 {
     if (new_capacity > capacity_)
     {
@@ -309,8 +581,8 @@ void vector<T>::reserve(size_t new_capacity)
     }
 }
 
-template <typename T>
-void vector<T>::shrink_to_fit()
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::shrink_to_fit()
 {
     if (capacity_ > size_)
     {
@@ -325,108 +597,206 @@ void vector<T>::shrink_to_fit()
     }
 }
 
-template <typename T>
-void vector<T>::clear()
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::resize(size_t n)
+{
+    resize(n, T());
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::resize(size_t n, T const& val)
+{
+    resize(n, val, parallel_policy(1));
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::resize(size_t n, T const& val, parallel_policy const& policy)
+{
+    if (n <= size_)
+    {
+        erase(begin() + n, end());
+        return;
+    }
+    // val may be an element of this vector that is about to be moved
+    T copy(val);
+    if (n > capacity_)
+    {
+        new_buffer(get_increased_capacity(n));
+    }
+    parallel_utils::uninitialized_fill(data_ + size_, n - size_, copy, policy);
+    size_ = n;
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::assign(size_t n, T const& val)
+{
+    assign(n, val, parallel_policy(1));
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::assign(size_t n, T const& val, parallel_policy const& policy)
+{
+    T copy(val);
+    clear();
+    if (n > capacity_)
+    {
+        full_clear();
+        init_fields(allocate(n), 0, n);
+    }
+    parallel_utils::uninitialized_fill(data_, n, copy, policy);
+    size_ = n;
+}
+
+template <typename T, typename Allocator, typename Growth>
+template <typename InputIt, typename>
+void vector<T, Allocator, Growth>::assign(InputIt first, InputIt last)
+{
+    clear();
+    insert(end(), first, last);
+}
+
+template <typename T, typename Allocator, typename Growth>
+template <typename RandomIt, typename>
+void vector<T, Allocator, Growth>::assign(RandomIt first, RandomIt last, parallel_policy const& policy)
+{
+    size_t n = std::distance(first, last);
+    clear();
+    if (n > capacity_)
+    {
+        full_clear();
+        init_fields(allocate(n), 0, n);
+    }
+    parallel_utils::uninitialized_copy(first, n, data_, policy);
+    size_ = n;
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::clear()
 {
     if (size_)
     {
-        destroy_all(data_, size_);
+        element_utils::destroy_all(data_, size_);
         size_ = 0;
     }
 }
 
-template <typename T>
-void vector<T>::swap(vector<T>& other)
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::swap(vector<T, Allocator, Growth>& other)
 {
-    using std::swap;
-    swap(data_, other.data_);
-    swap(size_, other.size_);
-    swap(capacity_, other.capacity_);
+    if (alloc_traits::propagate_on_container_swap::value)
+    {
+        using std::swap;
+        swap(alloc(), other.alloc());
+    }
+    swap_fields(other);
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::begin()
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::begin()
 {
     return data_;
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::end()
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::end()
 {
     return data_ + size_;
 }
 
-template <typename T>
-typename vector<T>::const_iterator vector<T>::begin() const
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::const_iterator vector<T, Allocator, Growth>::begin() const
 {
     return data_;
 }
 
-template <typename T>
-typename vector<T>::const_iterator vector<T>::end() const
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::const_iterator vector<T, Allocator, Growth>::end() const
 {
     return data_ + size_;
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::insert(iterator pos, T const& val)
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::insert(iterator pos, T const& val)
 {
     return insert(static_cast<const_iterator>(pos), val);
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::insert(const_iterator pos, T const& val)
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::insert(const_iterator pos, T const& val)
+{
+    return emplace(pos, val);
+}
+
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::insert(iterator pos, T&& val)
+{
+    return insert(static_cast<const_iterator>(pos), std::move(val));
+}
+
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::insert(const_iterator pos, T&& val)
+{
+    return emplace(pos, std::move(val));
+}
+
+template <typename T, typename Allocator, typename Growth>
+template <typename... Args>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::emplace(const_iterator pos, Args&&... args)
 {
     size_t at = pos - begin();
-    push_back(val);
-    size_t i = size_ - 1;
-    while (i != at)
-    {
-        std::swap(data_[i - 1], data_[i]);
-        --i;
-    }
+    emplace_back(std::forward<Args>(args)...);
+    element_utils::move_back_to(data_, size_, at);
+    return begin() + at;
+}
+
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::insert(const_iterator pos, size_t n, T const& val)
+{
+    size_t at = pos - begin();
+    // val may be an element of this vector that is about to be moved
+    T copy(val);
+    typedef element_utils::repeat_iterator<T> repeat_iterator;
+    insert_range(at, repeat_iterator(copy, 0), repeat_iterator(copy, n), std::forward_iterator_tag());
+    return begin() + at;
+}
+
+template <typename T, typename Allocator, typename Growth>
+template <typename InputIt, typename>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::insert(const_iterator pos, InputIt first, InputIt last)
+{
+    size_t at = pos - begin();
+    insert_range(at, first, last, typename std::iterator_traits<InputIt>::iterator_category());
     return begin() + at;
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::erase(iterator pos)
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::insert(const_iterator pos, std::initializer_list<T> list)
+{
+    return insert(pos, list.begin(), list.end());
+}
+
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::erase(iterator pos)
 {
     return erase(static_cast<const_iterator>(pos));
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::erase(const_iterator pos)
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::erase(const_iterator pos)
 {
     return erase(pos, pos + 1);
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::erase(iterator first, iterator last)
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::erase(iterator first, iterator last)
 {
     return erase(static_cast<const_iterator>(first), static_cast<const_iterator>(last));
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::erase(const_iterator first, const_iterator last)
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator vector<T, Allocator, Growth>::erase(const_iterator first, const_iterator last)
 {
-    size_t pos_end = last - begin();
     size_t shift = first - begin();
-    size_t dist = last - first;
-    size_t pos_begin = shift;
-    while (pos_begin != pos_end)
-    {
-        size_t i = pos_begin;
-        while (i + dist < size_)
-        {
-            std::swap(data_[i], data_[i + dist]);
-            i += dist;
-        }
-        ++pos_begin;
-    }
-    while (dist > 0)
-    {
-        pop_back();
-        --dist;
-    }
+    element_utils::erase_range(data_, size_, shift, last - begin());
     return begin() + shift;
 }
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "vector.h"
+#include "allocators.h"
+
+// Builds and copies vectors of N heavy elements and prints the time per element
+// for vector and std::vector. Growth moves the elements, so push_back costs
+// about one element copy and emplace_back about one element construction.
+// The int part covers the memcpy / memmove paths for trivially copyable types,
+// the growth part pushes 64M ints with each growth policy and with realloc / mremap,
+// the parallel part copies and fills 256M ints on one thread and on all hardware threads.
+
+namespace {
+    size_t const N = 1 << 20;
+    size_t const REPEATS = 5;
+
+    // Makes the compiler assume that the value is read and written
+    template <typename T>
+    void escape(T& value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    template <typename F>
+    double measure(F const& f) {
+        double best = 0;
+        for (size_t r = 0; r != REPEATS; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+            if (r == 0 || time.count() < best) {
+                best = time.count();
+            }
+        }
+        return best / N;
+    }
+
+    template <typename T>
+    void run(char const* name, T const& value) {
+        std::printf("%-16s     vector   std::vector\n", name);
+        std::printf("  push_back    %10.1f  %12.1f  ns/element\n",
+                    measure([&] {
+                        vector<T> v;
+                        for (size_t i = 0; i != N; ++i) {
+                            v.push_back(value);
+                        }
+                        escape(v);
+                    }),
+                    measure([&] {
+                        std::vector<T> v;
+                        for (size_t i = 0; i != N; ++i) {
+                            v.push_back(value);
+                        }
+                        escape(v);
+                    }));
+        std::printf("  emplace_back %10.1f  %12.1f  ns/element\n",
+                    measure([&] {
+                        vector<T> v;
+                        for (size_t i = 0; i != N; ++i) {
+                            v.emplace_back(value.begin(), value.end());
+                        }
+                        escape(v);
+                    }),
+                    measure([&] {
+                        std::vector<T> v;
+                        for (size_t i = 0; i != N; ++i) {
+                            v.emplace_back(value.begin(), value.end());
+                        }
+                        escape(v);
+                    }));
+
+        vector<T> source;
+        std::vector<T> std_source;
+        for (size_t i = 0; i != N; ++i) {
+            source.push_back(value);
+            std_source.push_back(value);
+        }
+        std::printf("  copy         %10.1f  %12.1f  ns/element\n",
+                    measure([&] {
+                        vector<T> copy = source;
+                        escape(copy);
+                    }),
+                    measure([&] {
+                        std::vector<T> copy = std_source;
+                        escape(copy);
+                    }));
+    }
+
+    template <template <typename...> class V>
+    void insert_erase(V<int>& v) {
+        for (size_t i = 0; i != 64; ++i) {
+            v.insert(v.begin() + v.size() / 2, static_cast<int>(i));
+        }
+        for (size_t i = 0; i != 64; ++i) {
+            v.erase(v.begin() + v.size() / 2);
+        }
+        v.erase(v.begin() + v.size() / 4, v.end() - v.size() / 4);
+    }
+
+    void run_int() {
+        std::printf("%-16s     vector   std::vector\n", "int");
+        std::printf("  push_back    %10.2f  %12.2f  ns/element\n",
+                    measure([&] {
+                        vector<int> v;
+                        for (size_t i = 0; i != N; ++i) {
+                            v.push_back(static_cast<int>(i));
+                        }
+                        escape(v);
+                    }),
+                    measure([&] {
+                        std::vector<int> v;
+                        for (size_t i = 0; i != N; ++i) {
+                            v.push_back(static_cast<int>(i));
+                        }
+                        escape(v);
+                    }));
+
+        vector<int> source;
+        std::vector<int> std_source;
+        for (size_t i = 0; i != N; ++i) {
+            source.push_back(static_cast<int>(i));
+            std_source.push_back(static_cast<int>(i));
+        }
+        std::printf("  copy         %10.2f  %12.2f  ns/element\n",
+                    measure([&] {
+                        vector<int> copy = source;
+                        escape(copy);
+                    }),
+                    measure([&] {
+                        std::vector<int> copy = std_source;
+                        escape(copy);
+                    }));
+        std::printf("  reserve      %10.2f  %12.2f  ns/element\n",
+                    measure([&] {
+                        vector<int> copy = source;
+                        copy.reserve(2 * N);
+                        escape(copy);
+                    }),
+                    measure([&] {
+                        std::vector<int> copy = std_source;
+                        copy.reserve(2 * N);
+                        escape(copy);
+                    }));
+        std::printf("  insert/erase %10.2f  %12.2f  ns/element\n",
+                    measure([&] {
+                        vector<int> copy = source;
+                        insert_erase(copy);
+                        escape(copy);
+                    }),
+                    measure([&] {
+                        std::vector<int> copy = std_source;
+                        insert_erase(copy);
+                        escape(copy);
+                    }));
+    }
+
+    template <typename V>
+    double push_back_large(size_t n) {
+        auto start = std::chrono::steady_clock::now();
+        {
+            V v;
+            for (size_t i = 0; i != n; ++i) {
+                v.push_back(static_cast<int>(i));
+            }
+            escape(v);
+        }
+        std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+        return time.count() / n;
+    }
+
+    void run_growth() {
+        size_t const n = 64 * N;
+        std::printf("%-16s  ns/element\n", "growth, 64M int");
+        std::printf("  2x             %8.2f\n", push_back_large<vector<int>>(n));
+        std::printf("  1.5x           %8.2f\n",
+                    push_back_large<vector<int, std::allocator<int>, one_and_half_growth>>(n));
+        std::printf("  size classes   %8.2f\n",
+                    push_back_large<vector<int, std::allocator<int>, size_class_growth>>(n));
+        std::printf("  2x, realloc    %8.2f\n", push_back_large<vector<int, realloc_allocator<int>>>(n));
+        std::printf("  1.5x, realloc  %8.2f\n",
+                    push_back_large<vector<int, realloc_allocator<int>, one_and_half_growth>>(n));
+        std::printf("  std::vector    %8.2f\n", push_back_large<std::vector<int>>(n));
+    }
+
+    void run_parallel() {
+        size_t const n = 256 * N;
+        parallel_policy serial(1);
+        parallel_policy parallel;
+        std::printf("%-16s  %8s  %8s  ns/element, %zu threads\n", "parallel, 256M int", "1 thread", "parallel",
+                    parallel.threads);
+        auto fill = [n](parallel_policy const& policy) {
+            return measure([&] {
+                vector<int> v;
+                v.resize(n, 42, policy);
+                escape(v);
+            }) * N / n;
+        };
+        std::printf("  resize           %8.2f  %8.2f\n", fill(serial), fill(parallel));
+
+        vector<int> source;
+        source.resize(n, 42, parallel);
+        auto copy = [n, &source](parallel_policy const& policy) {
+            return measure([&] {
+                vector<int> v(source, policy);
+                escape(v);
+            }) * N / n;
+        };
+        std::printf("  copy             %8.2f  %8.2f\n", copy(serial), copy(parallel));
+    }
+}
+
+int main() {
+    run("std::string", std::string(64, 'x'));
+    run("std::vector<int>", std::vector<int>(16, 42));
+    run_int();
+    run_growth();
+    run_parallel();
+    return 0;
+}